@@ -6,6 +6,9 @@
  * Refactored with love by Olivier Poncet
  */
 #include <cerrno>
+#include <cctype>
+#include <cfloat>
+#include <climits>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -16,12 +19,21 @@
 #include <vector>
 #include <queue>
 #include <mutex>
+#include <atomic>
+#include <csignal>
 #include <chrono>
 #include <memory>
+#include <new>
 #include <random>
 #include <thread>
 #include <iostream>
+#include <algorithm>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 #include "card.h"
 
 // ---------------------------------------------------------------------------
@@ -33,15 +45,185 @@
 #endif
 
 // ---------------------------------------------------------------------------
-// base::ramdom
+// base::sampler
+// ---------------------------------------------------------------------------
+
+namespace base {
+
+sampler::sampler(const method sampler_method, const uint32_t seed)
+    : _method(sampler_method)
+    , _seed(seed)
+    , _stream(0)
+    , _sample(0)
+    , _dimension(0)
+{
+}
+
+auto sampler::get(const uint32_t dimension) const -> float
+{
+    auto to_float = [](const uint32_t value) -> float
+    {
+        return static_cast<float>(value >> 8) * (1.0f / 16777216.0f);
+    };
+
+    switch(_method) {
+        case method::sobol:
+            return to_float(get_sobol(dimension));
+        case method::bluenoise:
+            return to_float(get_bluenoise(dimension));
+        default:
+            break;
+    }
+    return randomizer::uniform(_seed, _stream, _sample, dimension);
+}
+
+/*
+ * the dimensions are taken by pairs from the first two Sobol dimensions,
+ * every pair of every pixel having its own shuffled index and its own
+ * Owen scrambling (hash-based nested uniform scrambling)
+ */
+auto sampler::get_sobol(const uint32_t dimension) const -> uint32_t
+{
+    return sobol(_sample, dimension, randomizer::hash(_seed, _stream, (dimension >> 1), UINT32_C(0x9e3779b9)));
+}
+
+/*
+ * the same scrambled Sobol sequence for all the pixels, each pixel being
+ * rotated by an R2 dither of its coordinates which has a blue-noise-like
+ * spectrum, the stream holding the pixel coordinates
+ */
+auto sampler::get_bluenoise(const uint32_t dimension) const -> uint32_t
+{
+    const uint32_t x      = (_stream & 0xffff);
+    const uint32_t y      = (_stream >> 16);
+    const uint32_t dither = (x * UINT32_C(3242174889)) + (y * UINT32_C(2447445413));
+    const uint32_t offset = randomizer::hash(_seed, 0, (dimension >> 1), (dimension & 1));
+
+    return sobol(_sample, dimension, randomizer::hash(_seed, 0, (dimension >> 1), UINT32_C(0x9e3779b9)))
+         + ((dimension & 1) != 0 ? ~dither : dither)
+         + offset;
+}
+
+auto sampler::sobol(const uint32_t sample, const uint32_t dimension, const uint32_t seed) -> uint32_t
+{
+    const uint32_t index = scramble(sample, seed);
+    uint32_t       value = 0;
+
+    if((dimension & 1) == 0) {
+        value = reverse(index);
+    }
+    else {
+        uint32_t direction = UINT32_C(1) << 31;
+        for(uint32_t bits = index; bits != 0; bits >>= 1, direction ^= (direction >> 1)) {
+            if((bits & 1) != 0) {
+                value ^= direction;
+            }
+        }
+    }
+    return scramble(value, randomizer::mix(seed + (dimension & 1) + 1));
+}
+
+auto sampler::reverse(uint32_t value) -> uint32_t
+{
+    value = ((value >> 1) & UINT32_C(0x55555555)) | ((value & UINT32_C(0x55555555)) << 1);
+    value = ((value >> 2) & UINT32_C(0x33333333)) | ((value & UINT32_C(0x33333333)) << 2);
+    value = ((value >> 4) & UINT32_C(0x0f0f0f0f)) | ((value & UINT32_C(0x0f0f0f0f)) << 4);
+    value = ((value >> 8) & UINT32_C(0x00ff00ff)) | ((value & UINT32_C(0x00ff00ff)) << 8);
+    return (value >> 16) | (value << 16);
+}
+
+auto sampler::scramble(uint32_t value, const uint32_t seed) -> uint32_t
+{
+    value  = reverse(value);
+    value ^= value * UINT32_C(0x3d20adea);
+    value += seed;
+    value *= (seed >> 16) | 1;
+    value ^= value * UINT32_C(0x05526c56);
+    value ^= value * UINT32_C(0x53a22864);
+    return reverse(value);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// base::arena
 // ---------------------------------------------------------------------------
 
 namespace base {
 
-randomizer::randomizer(const float min, const float max)
-    : _generator(::time(nullptr))
-    , _distributor(min, max)
+arena::arena(const size_t chunk_size)
+    : _chunks()
+    , _destructors()
+    , _chunk_size(chunk_size)
+    , _size(0)
+{
+}
+
+arena::~arena()
+{
+    clear();
+}
+
+/*
+ * monotonic allocation, a new chunk at least twice as large as the last
+ * one being allocated whenever the current one is exhausted
+ */
+void* arena::allocate(const size_t size, const size_t alignment)
+{
+    auto try_allocate = [&]() -> void*
+    {
+        if(_chunks.empty()) {
+            return nullptr;
+        }
+        chunk&          current = _chunks.back();
+        const uintptr_t address = reinterpret_cast<uintptr_t>(current.data) + current.used;
+        const size_t    padding = (alignment - (address % alignment)) % alignment;
+        if((current.used + padding + size) > current.size) {
+            return nullptr;
+        }
+        current.used += (padding + size);
+        _size        += (padding + size);
+        return current.data + (current.used - size);
+    };
+
+    auto add_chunk = [&]() -> void
+    {
+        const size_t last  = (_chunks.empty() ? (_chunk_size / 2) : _chunks.back().size);
+        const size_t bytes = std::max(last * 2, size + alignment);
+        void*        data  = nullptr;
+        if(::posix_memalign(&data, 64, bytes) != 0) {
+            throw std::bad_alloc();
+        }
+        _chunks.push_back(chunk { static_cast<uint8_t*>(data), bytes, 0 });
+    };
+
+    auto execute = [&]() -> void*
+    {
+        void* pointer = try_allocate();
+        if(pointer == nullptr) {
+            add_chunk();
+            pointer = try_allocate();
+        }
+        return pointer;
+    };
+
+    return execute();
+}
+
+/*
+ * only the objects that are not trivially destructible cost anything here
+ */
+void arena::clear()
 {
+    for(auto it = _destructors.rbegin(); it != _destructors.rend(); ++it) {
+        (*it->function)(it->object);
+    }
+    for(auto& chunk : _chunks) {
+        ::free(chunk.data);
+    }
+    _destructors.clear();
+    _chunks.clear();
+    _size = 0;
 }
 
 }
@@ -114,22 +296,198 @@ namespace ppm {
 
 reader::reader(const std::string& filename)
     : stream(filename)
+    , _format(0)
 {
 }
 
+/*
+ * only the bitmaps (P1 and P4) are supported, their maxval being 1
+ */
 void reader::open(int& width, int& height, int& maxval)
 {
-    throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "not implemented");
+    auto do_check = [&]() -> void
+    {
+        if(_stream != nullptr) {
+            throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "file is already opened");
+        }
+        if(_buffer != nullptr) {
+            throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "buffer is already allocated");
+        }
+    };
+
+    auto do_open = [&]() -> void
+    {
+        if((_stream = ::fopen(_filename.c_str(), "r")) == nullptr) {
+            throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + '<' + _filename + '>');
+        }
+    };
+
+    auto get_value = [&]() -> int
+    {
+        int character = ::fgetc(_stream);
+        while(true) {
+            if(character == '#') {
+                while((character != '\n') && (character != EOF)) {
+                    character = ::fgetc(_stream);
+                }
+            }
+            else if(::isspace(character) != 0) {
+                character = ::fgetc(_stream);
+            }
+            else {
+                break;
+            }
+        }
+        if(::isdigit(character) == 0) {
+            throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "invalid header");
+        }
+        int value = 0;
+        while(::isdigit(character) != 0) {
+            value = (value * 10) + (character - '0');
+            if(value > 65536) {
+                throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "invalid header");
+            }
+            character = ::fgetc(_stream);
+        }
+        /* the single whitespace following the value is consumed */
+        return value;
+    };
+
+    auto do_header = [&]() -> void
+    {
+        const int magic = ::fgetc(_stream);
+        const int digit = ::fgetc(_stream);
+        if((magic != 'P') || ((digit != '1') && (digit != '4'))) {
+            throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "unsupported format");
+        }
+        _format = (digit - '0');
+        _width  = get_value();
+        _height = get_value();
+        _maxval = 1;
+        if(_width <= 0) {
+            throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "invalid width");
+        }
+        if(_height <= 0) {
+            throw std::runtime_error(std::string("ppm::reader is unable to open") + ',' + ' ' + "invalid height");
+        }
+    };
+
+    auto do_setup = [&]() -> void
+    {
+        width  = _width;
+        height = _height;
+        maxval = _maxval;
+    };
+
+    auto execute = [&]() -> void
+    {
+        do_check();
+        do_open();
+        do_header();
+        do_setup();
+    };
+
+    return execute();
 }
 
+/*
+ * the buffer holds one byte per pixel, 1 being black
+ */
 void reader::fetch()
 {
-    throw std::runtime_error(std::string("ppm::reader is unable to fetch") + ',' + ' ' + "not implemented");
+    auto do_check = [&]() -> void
+    {
+        if(_stream == nullptr) {
+            throw std::runtime_error(std::string("ppm::reader is unable to fetch") + ',' + ' ' + "file is not opened");
+        }
+        if(_buffer != nullptr) {
+            throw std::runtime_error(std::string("ppm::reader is unable to fetch") + ',' + ' ' + "buffer is already allocated");
+        }
+    };
+
+    auto do_allocate = [&]() -> void
+    {
+        if((_buffer = new uint8_t[_length = (static_cast<size_t>(_height) * _width)]) == nullptr) {
+            throw std::runtime_error(std::string("ppm::reader is unable to fetch") + ',' + ' ' + "error while allocating buffer");
+        }
+    };
+
+    auto do_fetch_ascii = [&]() -> void
+    {
+        for(size_t index = 0; index < _length; ++index) {
+            int character = ::fgetc(_stream);
+            while((::isspace(character) != 0) || (character == '#')) {
+                if(character == '#') {
+                    while((character != '\n') && (character != EOF)) {
+                        character = ::fgetc(_stream);
+                    }
+                }
+                character = ::fgetc(_stream);
+            }
+            if((character != '0') && (character != '1')) {
+                throw std::runtime_error(std::string("ppm::reader is unable to fetch") + ',' + ' ' + "error while reading");
+            }
+            _buffer[index] = static_cast<uint8_t>(character - '0');
+        }
+    };
+
+    auto do_fetch_binary = [&]() -> void
+    {
+        const size_t         stride = (_width + 7) / 8;
+        std::vector<uint8_t> bytes(stride);
+        uint8_t*             pixel = _buffer;
+        for(int row = 0; row < _height; ++row) {
+            if(::fread(bytes.data(), sizeof(uint8_t), stride, _stream) != stride) {
+                throw std::runtime_error(std::string("ppm::reader is unable to fetch") + ',' + ' ' + "error while reading");
+            }
+            for(int col = 0; col < _width; ++col) {
+                *pixel++ = ((bytes[col >> 3] >> (7 - (col & 7))) & 1);
+            }
+        }
+    };
+
+    auto execute = [&]() -> void
+    {
+        do_check();
+        do_allocate();
+        if(_format == 1) {
+            do_fetch_ascii();
+        }
+        else {
+            do_fetch_binary();
+        }
+    };
+
+    return execute();
 }
 
 void reader::close()
 {
-    throw std::runtime_error(std::string("ppm::reader is unable to close") + ',' + ' ' + "not implemented");
+    auto do_check = [&]() -> void
+    {
+        if(_stream == nullptr) {
+            throw std::runtime_error(std::string("ppm::reader is unable to close") + ',' + ' ' + "file is not opened");
+        }
+    };
+
+    auto do_close = [&]() -> void
+    {
+        if(_buffer != nullptr) {
+            _buffer = (delete[] _buffer, nullptr);
+            _length = 0;
+        }
+        if(_stream != nullptr) {
+            _stream = (static_cast<void>(::fclose(_stream)), nullptr);
+        }
+    };
+
+    auto execute = [&]() -> void
+    {
+        do_check();
+        do_close();
+    };
+
+    return execute();
 }
 
 }
@@ -278,6 +636,14 @@ namespace rt {
 
 }
 
+// ---------------------------------------------------------------------------
+// rt::hit_record
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+}
+
 // ---------------------------------------------------------------------------
 // rt::ray
 // ---------------------------------------------------------------------------
@@ -286,6 +652,75 @@ namespace rt {
 
 }
 
+// ---------------------------------------------------------------------------
+// rt::ray_packet
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+ray_packet::ray_packet()
+    : ox()
+    , oy()
+    , oz()
+    , ix()
+    , iy()
+    , iz()
+    , rays()
+    , origins()
+    , inverses()
+    , _size(0)
+    , _coherent(true)
+{
+}
+
+void ray_packet::clear()
+{
+    for(int lane = 0; lane < _size; ++lane) {
+        ox[lane] = oy[lane] = oz[lane] = 0.0f;
+        ix[lane] = iy[lane] = iz[lane] = 0.0f;
+    }
+    origins  = box3f();
+    inverses = box3f();
+    _size     = 0;
+    _coherent = true;
+}
+
+/*
+ * the packet is coherent when the inverse directions of all rays are finite
+ * and share their signs, which is what the interval culling relies on
+ */
+void ray_packet::add(const ray& ray)
+{
+    if(_size >= LANES_MAX) {
+        throw std::runtime_error(std::string("rt::ray_packet is unable to add") + ',' + ' ' + "packet is full");
+    }
+    const int   lane = _size++;
+    const pos3f inverse ( (1.0f / ray.direction.x)
+                        , (1.0f / ray.direction.y)
+                        , (1.0f / ray.direction.z) );
+
+    auto same_signs = [](const float lhs, const float rhs) -> bool
+    {
+        return ((lhs > 0.0f) && (rhs > 0.0f)) || ((lhs < 0.0f) && (rhs < 0.0f));
+    };
+
+    rays[lane] = ray;
+    ox[lane] = ray.origin.x;
+    oy[lane] = ray.origin.y;
+    oz[lane] = ray.origin.z;
+    ix[lane] = inverse.x;
+    iy[lane] = inverse.y;
+    iz[lane] = inverse.z;
+    origins  += ray.origin;
+    inverses += inverse;
+    _coherent = _coherent
+             && std::isfinite(inverse.x) && same_signs(inverses.min.x, inverses.max.x)
+             && std::isfinite(inverse.y) && same_signs(inverses.min.y, inverses.max.y)
+             && std::isfinite(inverse.z) && same_signs(inverses.min.z, inverses.max.z);
+}
+
+}
+
 // ---------------------------------------------------------------------------
 // rt::camera
 // ---------------------------------------------------------------------------
@@ -332,103 +767,248 @@ namespace rt {
 
 light::light ( const pos3f& light_position
              , const col3f& light_color
-             , const float  light_power )
+             , const float  light_power
+             , const float  light_radius )
     : position(light_position)
     , color(light_color)
     , power(light_power)
+    , radius(light_radius)
 {
 }
 
 }
 
 // ---------------------------------------------------------------------------
-// rt::sky
+// rt::cone
 // ---------------------------------------------------------------------------
 
 namespace rt {
 
-sky::sky ( const col3f& sky_color
-         , const col3f& sky_ambient )
-         : color(sky_color)
-         , ambient(sky_ambient)
+cone::cone ( const ray&  cone_axis
+           , const float cone_distance
+           , const float cone_radius )
+    : axis(cone_axis)
+    , distance(cone_distance)
+    , radius(cone_radius)
+    , angle(0.0f)
+    , tangent(0.0f)
+{
+    if((radius > 0.0f) && (radius < distance)) {
+        const float sine = radius / distance;
+        angle   = ::asinf(sine);
+        tangent = sine / ::sqrtf(1.0f - (sine * sine));
+    }
+}
+
+bool cone::enter(const box3f& bounds) const
+{
+    const vec3f oc(pos3f::difference(bounds.center(), axis.origin));
+    const float extent = vec3f::length(pos3f::difference(bounds.max, bounds.min)) * 0.5f;
+    const float along  = vec3f::dot(oc, axis.direction);
+
+    if(((along + extent) < 0.0f) || ((along - extent) > distance)) {
+        return false;
+    }
+    const float across = ::sqrtf(std::max((vec3f::dot(oc, oc) - (along * along)), 0.0f));
+
+    return (across - extent) <= ((along + extent) * tangent);
+}
+
+/*
+ * the light is seen from the apex as a disc of angular radius asin(r/d),
+ * a sphere in front of it hiding the lens where its own disc overlaps the
+ * one of the light, the sphere holding the apex being left to the diffuse
+ * term as it is by the shadow rays
+ */
+auto cone::cover(const pos3f& center, const float sphere_radius) const -> float
 {
+    constexpr float pi = 3.14159265f;
+    const vec3f oc(pos3f::difference(center, axis.origin));
+    const float length = vec3f::length(oc);
+
+    if((length <= (sphere_radius * 1.001f)) || ((length - sphere_radius) >= distance)) {
+        return 0.0f;
+    }
+    const float along  = vec3f::dot(oc, axis.direction);
+    const float across = ::sqrtf(std::max((vec3f::dot(oc, oc) - (along * along)), 0.0f));
+    const float a = angle;
+    const float b = ::asinf(sphere_radius / length);
+    const float d = ::atan2f(across, along);
+
+    if(d >= (a + b)) {
+        return 0.0f;
+    }
+    if(d <= (b - a)) {
+        return 1.0f;
+    }
+    if(d <= (a - b)) {
+        return (b * b) / (a * a);
+    }
+    const float lhs = (a * a) * ::acosf(std::min(std::max(((d * d) + (a * a) - (b * b)) / (2.0f * d * a), -1.0f), 1.0f));
+    const float rhs = (b * b) * ::acosf(std::min(std::max(((d * d) + (b * b) - (a * a)) / (2.0f * d * b), -1.0f), 1.0f));
+    const float mid = 0.5f * ::sqrtf(std::max(((a + b - d) * (d + a - b) * (d - a + b) * (d + a + b)), 0.0f));
+
+    return std::min(std::max(((lhs + rhs - mid) / (pi * a * a)), 0.0f), 1.0f);
 }
 
 }
 
 // ---------------------------------------------------------------------------
-// rt::object
+// rt::sky
 // ---------------------------------------------------------------------------
 
 namespace rt {
 
-object::object()
-    : _color0(0.5f, 0.5f, 0.5f)
-    , _color1(1.0f, 0.3f, 0.3f)
-    , _color2(1.0f, 1.0f, 1.0f)
-    , _reflect(0.0f)
-    , _refract(0.0f)
-    , _eta(1.0f)
-    , _specular(0.0f)
+sky::sky ( const col3f& sky_color
+         , const col3f& sky_ambient )
+         : color(sky_color)
+         , ambient(sky_ambient)
 {
 }
 
 }
 
 // ---------------------------------------------------------------------------
-// rt::plane
+// rt::material
 // ---------------------------------------------------------------------------
 
 namespace rt {
 
-plane::plane ( const pos3f& plane_position
-             , const vec3f& plane_normal
-             , const float  plane_scale )
-    : object()
-    , _position(plane_position)
-    , _normal(plane_normal, true)
-    , _scale(plane_scale)
+material::material ( const col3f& material_color0
+                   , const col3f& material_color1
+                   , const col3f& material_color2
+                   , const float  material_reflect
+                   , const float  material_refract
+                   , const float  material_eta
+                   , const float  material_specular )
+    : color0(material_color0)
+    , color1(material_color1)
+    , color2(material_color2)
+    , reflect(material_reflect)
+    , refract(material_refract)
+    , eta(material_eta)
+    , specular(material_specular)
 {
 }
 
-bool plane::hit(const ray& ray, hit_result& result) const
+bool material::operator==(const material& other) const
 {
-    auto color = [&]() -> const col3f&
+    auto same = [](const col3f& lhs, const col3f& rhs) -> bool
     {
-        const float x = ::roundf(result.position.x * _scale);
-        const float y = ::roundf(result.position.y * _scale);
-        const float z = ::roundf(result.position.z * _scale);
-        const int   c = (static_cast<int>(x) & 1)
-                      ^ (static_cast<int>(y) & 1)
-                      ^ (static_cast<int>(z) & 1)
-                      ;
-
-        return (c != 0 ? _color1 : _color2);
+        return (lhs.r == rhs.r) && (lhs.g == rhs.g) && (lhs.b == rhs.b);
     };
 
-    const vec3f oc(pos3f::difference(ray.origin, _position));
-    constexpr float distance_min = hit_result::DISTANCE_MIN;
-    const     float distance_max = result.distance;
-    const     float distance_hit = -vec3f::dot(oc, _normal) / vec3f::dot(ray.direction, _normal);
-    if((distance_hit > distance_min) && (distance_hit < distance_max)) {
-        const vec3f length((ray.direction * distance_hit));
-        result.distance = distance_hit;
-        result.position = pos3f(ray.origin + length);
-        result.normal   = _normal;
-        result.color    = color();
-        result.reflect  = _reflect;
-        result.refract  = _refract;
-        result.eta      = _eta;
-        result.specular = _specular;
-        return true;
-    }
-    return false;
+    return same(color0, other.color0)
+        && same(color1, other.color1)
+        && same(color2, other.color2)
+        && (reflect  == other.reflect)
+        && (refract  == other.refract)
+        && (eta      == other.eta)
+        && (specular == other.specular);
 }
 
 }
 
 // ---------------------------------------------------------------------------
-// rt::sphere
+// rt::object
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+object::object()
+    : _material(0)
+{
+}
+
+/*
+ * objects without a cone test only block the axis of the cone, which
+ * gives them hard shadows
+ */
+auto object::visibility(const cone& cone) const -> float
+{
+    return (occluded(cone.axis, cone.distance) ? 0.0f : 1.0f);
+}
+
+/*
+ * objects without primitives of their own are their single occluder
+ */
+auto object::occluder(const ray& ray, const float distance) const -> int
+{
+    return (occluded(ray, distance) ? 0 : -1);
+}
+
+bool object::occludes(const ray& ray, const float distance, const int primitive) const
+{
+    static_cast<void>(primitive);
+
+    return occluded(ray, distance);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::plane
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+plane::plane ( const pos3f& plane_position
+             , const vec3f& plane_normal
+             , const float  plane_scale )
+    : object()
+    , _position(plane_position)
+    , _normal(plane_normal, true)
+    , _scale(plane_scale)
+{
+}
+
+bool plane::hit(const ray& ray, hit_record& record) const
+{
+    const vec3f oc(pos3f::difference(ray.origin, _position));
+    constexpr float distance_min = hit_result::DISTANCE_MIN;
+    const     float distance_max = record.distance;
+    const     float distance_hit = -vec3f::dot(oc, _normal) / vec3f::dot(ray.direction, _normal);
+    if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+        record.set(distance_hit, hit_record::kind::object, this, 0);
+        return true;
+    }
+    return false;
+}
+
+void plane::resolve(const ray& ray, const hit_record& record, const material& material, hit_result& result) const
+{
+    const vec3f length((ray.direction * record.distance));
+    result.distance = record.distance;
+    result.position = pos3f(ray.origin + length);
+    result.normal   = _normal;
+    result.color    = checker(result.position, _scale, material.color1, material.color2);
+    result.reflect  = material.reflect;
+    result.refract  = material.refract;
+    result.eta      = material.eta;
+    result.specular = material.specular;
+}
+
+bool plane::occluded(const ray& ray, const float distance) const
+{
+    const vec3f oc(pos3f::difference(ray.origin, _position));
+    constexpr float distance_min = hit_result::DISTANCE_MIN;
+    const     float distance_max = distance;
+    const     float distance_hit = -vec3f::dot(oc, _normal) / vec3f::dot(ray.direction, _normal);
+    if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+        return true;
+    }
+    return false;
+}
+
+bool plane::bounds(box3f& box) const
+{
+    return false;
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere
 // ---------------------------------------------------------------------------
 
 namespace rt {
@@ -441,7 +1021,7 @@ sphere::sphere ( const pos3f& sphere_position
 {
 }
 
-bool sphere::hit(const ray& ray, hit_result& result) const
+bool sphere::hit(const ray& ray, hit_record& record) const
 {
     const vec3f oc(pos3f::difference(ray.origin, _position));
 #if 0
@@ -454,18 +1034,10 @@ bool sphere::hit(const ray& ray, hit_result& result) const
     const float delta = ((b * b) - (4.0f * a * c));
     if(delta > 0.0f) {
         constexpr float distance_min = hit_result::DISTANCE_MIN;
-        const     float distance_max = result.distance;
+        const     float distance_max = record.distance;
         const     float distance_hit = ((-b - ::sqrtf(delta)) / (2.0f * a));
         if((distance_hit > distance_min) && (distance_hit < distance_max)) {
-            const vec3f length(ray.direction * distance_hit);
-            result.distance = distance_hit;
-            result.position = pos3f(ray.origin + length);
-            result.normal   = vec3f(oc + length, true);
-            result.color    = _color0;
-            result.reflect  = _reflect;
-            result.refract  = _refract;
-            result.eta      = _eta;
-            result.specular = _specular;
+            record.set(distance_hit, hit_record::kind::object, this, 0);
             return true;
         }
     }
@@ -478,18 +1050,10 @@ bool sphere::hit(const ray& ray, hit_result& result) const
     const float delta = ((b * b) - c);
     if(delta > 0.0f) {
         constexpr float distance_min = hit_result::DISTANCE_MIN;
-        const     float distance_max = result.distance;
+        const     float distance_max = record.distance;
         const     float distance_hit = (-b - ::sqrtf(delta));
         if((distance_hit > distance_min) && (distance_hit < distance_max)) {
-            const vec3f length(ray.direction * distance_hit);
-            result.distance = distance_hit;
-            result.position = pos3f(ray.origin + length);
-            result.normal   = vec3f(oc + length, true);
-            result.color    = _color0;
-            result.reflect  = _reflect;
-            result.refract  = _refract;
-            result.eta      = _eta;
-            result.specular = _specular;
+            record.set(distance_hit, hit_record::kind::object, this, 0);
             return true;
         }
     }
@@ -497,164 +1061,3474 @@ bool sphere::hit(const ray& ray, hit_result& result) const
     return false;
 }
 
+void sphere::resolve(const ray& ray, const hit_record& record, const material& material, hit_result& result) const
+{
+    const vec3f oc(pos3f::difference(ray.origin, _position));
+    const vec3f length(ray.direction * record.distance);
+    result.distance = record.distance;
+    result.position = pos3f(ray.origin + length);
+    result.normal   = vec3f(oc + length, true);
+    result.color    = material.color0;
+    result.reflect  = material.reflect;
+    result.refract  = material.refract;
+    result.eta      = material.eta;
+    result.specular = material.specular;
+}
+
+bool sphere::occluded(const ray& ray, const float distance) const
+{
+    const vec3f oc(pos3f::difference(ray.origin, _position));
+    const float b = vec3f::dot(oc, ray.direction);
+    const float c = vec3f::dot(oc, oc) - (_radius * _radius);
+    const float delta = ((b * b) - c);
+    if(delta > 0.0f) {
+        constexpr float distance_min = hit_result::DISTANCE_MIN;
+        const     float distance_max = distance;
+        const     float distance_hit = (-b - ::sqrtf(delta));
+        if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto sphere::visibility(const cone& cone) const -> float
+{
+    return (1.0f - cone.cover(_position, _radius));
+}
+
+bool sphere::bounds(box3f& box) const
+{
+    const vec3f radius((_radius * 1.001f), (_radius * 1.001f), (_radius * 1.001f));
+
+    box = box3f(_position - radius, _position + radius);
+
+    return true;
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere_grid
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+sphere_grid::sphere_grid ( const pos3f& grid_origin
+                         , const int    grid_cols
+                         , const int    grid_rows
+                         , const float  grid_radius )
+    : object()
+    , _origin(grid_origin)
+    , _cols(grid_cols)
+    , _rows(grid_rows)
+    , _radius(grid_radius)
+    , _reach(static_cast<int>(::ceilf(grid_radius - 0.5f)))
+    , _width(0)
+    , _height(0)
+    , _stride(0)
+    , _count(0)
+    , _bounds()
+    , _spheres()
+    , _cells()
+{
+    if((_cols <= 0) || (_rows <= 0)) {
+        throw std::runtime_error(std::string("rt::sphere_grid is unable to create") + ',' + ' ' + "invalid size");
+    }
+    if((_radius <= 0.0f) || (_reach >= 32)) {
+        throw std::runtime_error(std::string("rt::sphere_grid is unable to create") + ',' + ' ' + "invalid radius");
+    }
+    if(_reach < 0) {
+        _reach = 0;
+    }
+    _width  = _cols + (2 * _reach);
+    _height = _rows + (2 * _reach);
+    _stride = (_width + 63) / 64;
+    _spheres.resize(_stride * _height);
+    _cells.resize(_stride * _height);
+}
+
+/*
+ * distance to the near side of the sphere, negative when it is missed
+ */
+auto sphere_grid::intersect(const ray& ray, const pos3f& center) const -> float
+{
+    const vec3f oc(pos3f::difference(ray.origin, center));
+    const float b = vec3f::dot(oc, ray.direction);
+    const float c = vec3f::dot(oc, oc) - (_radius * _radius);
+    const float delta = ((b * b) - c);
+
+    if(delta > 0.0f) {
+        return (-b - ::sqrtf(delta));
+    }
+    return -1.0f;
+}
+
+template <typename Function>
+bool sphere_grid::walk(const ray& ray, const float& distance_limit, Function&& function) const
+{
+    /*
+     * the grid is made of extended cells, each one being one lattice unit
+     * wide and padded by the sphere reach so that every sphere overlapping
+     * a cell lies in the (2 * reach + 1)^2 window centered on that cell
+     */
+    const vec3f inverse ( (1.0f / ray.direction.x)
+                        , (1.0f / ray.direction.y)
+                        , (1.0f / ray.direction.z) );
+    float distance_min = 0.0f;
+    float distance_max = 0.0f;
+
+    /* clip the ray to the |y| <= radius slab and to the occupied extents */ {
+        const box3f& box(_bounds);
+        const float x1 = (box.min.x - ray.origin.x) * inverse.x;
+        const float x2 = (box.max.x - ray.origin.x) * inverse.x;
+        const float y1 = (box.min.y - ray.origin.y) * inverse.y;
+        const float y2 = (box.max.y - ray.origin.y) * inverse.y;
+        const float z1 = (box.min.z - ray.origin.z) * inverse.z;
+        const float z2 = (box.max.z - ray.origin.z) * inverse.z;
+        distance_min = std::max(std::max(std::min(x1, x2), std::min(y1, y2)), std::max(std::min(z1, z2), 0.0f));
+        distance_max = std::min(std::min(std::max(x1, x2), std::max(y1, y2)), std::min(std::max(z1, z2), distance_limit));
+        if(distance_min > distance_max) {
+            return false;
+        }
+    }
+
+    const float offset    = static_cast<float>(_reach) + 0.5f;
+    const float u         = (ray.origin.x + (ray.direction.x * distance_min)) - _origin.x + offset;
+    const float v         = (ray.origin.z + (ray.direction.z * distance_min)) - _origin.z + offset;
+    const bool  col_moves = (ray.direction.x != 0.0f);
+    const bool  row_moves = (ray.direction.z != 0.0f);
+    const int   col_step  = (ray.direction.x < 0.0f ? -1 : +1);
+    const int   row_step  = (ray.direction.z < 0.0f ? -1 : +1);
+    const float col_delta = (col_moves ? ::fabsf(inverse.x) : FLT_MAX);
+    const float row_delta = (row_moves ? ::fabsf(inverse.z) : FLT_MAX);
+    const int   window    = (2 * _reach) + 1;
+    int         col       = std::min(std::max(static_cast<int>(::floorf(u)), 0), _width  - 1);
+    int         row       = std::min(std::max(static_cast<int>(::floorf(v)), 0), _height - 1);
+    float       col_next  = (col_moves ? distance_min + ((static_cast<float>(col + (col_step > 0)) - u) * inverse.x) : FLT_MAX);
+    float       row_next  = (row_moves ? distance_min + ((static_cast<float>(row + (row_step > 0)) - v) * inverse.z) : FLT_MAX);
+    float       distance  = distance_min;
+    int         prev_col  = -_width;
+    int         prev_row  = -_height;
+    bool        stopped   = false;
+
+    auto test = [&](const int sphere_col, const int sphere_row) -> void
+    {
+        const int   grid_col = sphere_col - _reach;
+        const int   grid_row = sphere_row - _reach;
+        const pos3f center ( _origin.x + static_cast<float>(grid_col)
+                           , _origin.y
+                           , _origin.z + static_cast<float>(grid_row) );
+        stopped = function(center, (grid_row * _cols) + grid_col);
+    };
+
+    /*
+     * the DDA path is monotone, so the window of the previously tested cell
+     * contains every sphere already tested that is also in the current one
+     */
+    auto test_cell = [&]() -> void
+    {
+        const int      first = col - _reach;
+        const int      shift = prev_col - col;
+        const uint64_t full  = ((uint64_t(1) << window) - 1);
+        const uint64_t prev  = (shift >= window || shift <= -window ? 0 : (shift >= 0 ? (full << shift) : (full >> -shift)) & full);
+        for(int sphere_row = row - _reach; sphere_row <= row + _reach; ++sphere_row) {
+            uint64_t mask = fetch(_spheres, first, sphere_row, window);
+            if((sphere_row >= prev_row - _reach) && (sphere_row <= prev_row + _reach)) {
+                mask &= ~prev;
+            }
+            while((mask != 0) && (stopped == false)) {
+                test(first + __builtin_ctzll(mask), sphere_row);
+                mask &= (mask - 1);
+            }
+        }
+        prev_col = col;
+        prev_row = row;
+    };
+
+    auto step_row = [&]() -> void
+    {
+        row      += row_step;
+        distance  = row_next;
+        row_next += row_delta;
+    };
+
+    auto step_cell = [&]() -> void
+    {
+        if(col_next < row_next) {
+            col      += col_step;
+            distance  = col_next;
+            col_next += col_delta;
+        }
+        else {
+            step_row();
+        }
+    };
+
+    auto skip_cells = [&]() -> void
+    {
+        if(col_moves == false) {
+            return step_row();
+        }
+        const int   target = next(col, row, col_step);
+        const int   steps  = (target - col) * col_step;
+        const float enter  = col_next + (static_cast<float>(steps - 1) * col_delta);
+        if(enter < row_next) {
+            col      = target;
+            distance = enter;
+            col_next = enter + col_delta;
+        }
+        else {
+            int crossed = 0;
+            if(col_next < row_next) {
+                crossed = std::min(steps - 1, static_cast<int>(::ceilf((row_next - col_next) / col_delta)));
+            }
+            col      += (crossed * col_step);
+            col_next += (static_cast<float>(crossed) * col_delta);
+            step_row();
+        }
+    };
+
+    auto inside = [&]() -> bool
+    {
+        if((col < 0) || (col >= _width) || (row < 0) || (row >= _height)) {
+            return false;
+        }
+        if((distance > distance_max) || (distance > distance_limit)) {
+            return false;
+        }
+        return true;
+    };
+
+    while((stopped == false) && inside()) {
+        if(fetch(_cells, col, row, 1) != 0) {
+            test_cell();
+            step_cell();
+        }
+        else {
+            skip_cells();
+        }
+    }
+    return stopped;
+}
+
+bool sphere_grid::hit(const ray& ray, hit_record& record) const
+{
+    bool status = false;
+
+    auto test = [&](const pos3f& center, const int primitive) -> bool
+    {
+        constexpr float distance_min = hit_result::DISTANCE_MIN;
+        const     float distance_max = record.distance;
+        const     float distance_hit = intersect(ray, center);
+        if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+            record.set(distance_hit, hit_record::kind::object, this, primitive);
+            status = true;
+        }
+        return false;
+    };
+
+    static_cast<void>(walk(ray, record.distance, test));
+
+    return status;
+}
+
+void sphere_grid::resolve(const ray& ray, const hit_record& record, const material& material, hit_result& result) const
+{
+    const pos3f center(get_center(record.primitive));
+    const vec3f oc(pos3f::difference(ray.origin, center));
+    const vec3f length(ray.direction * record.distance);
+    result.distance = record.distance;
+    result.position = pos3f(ray.origin + length);
+    result.normal   = vec3f(oc + length, true);
+    result.color    = material.color0;
+    result.reflect  = material.reflect;
+    result.refract  = material.refract;
+    result.eta      = material.eta;
+    result.specular = material.specular;
+}
+
+bool sphere_grid::occluded(const ray& ray, const float distance) const
+{
+    return occluder(ray, distance) >= 0;
+}
+
+/*
+ * the cone is clipped to the slab of the grid, the cells under the span of
+ * the clipped part being the only ones that may hide the light
+ */
+auto sphere_grid::visibility(const cone& cone) const -> float
+{
+    const ray&  axis(cone.axis);
+    const float slab    = _radius + (cone.distance * cone.tangent);
+    float       visible = 1.0f;
+    float       near    = 0.0f;
+    float       far     = cone.distance;
+
+    if(::fabsf(axis.direction.y) > 1e-6f) {
+        const float t0 = ((_origin.y - slab) - axis.origin.y) / axis.direction.y;
+        const float t1 = ((_origin.y + slab) - axis.origin.y) / axis.direction.y;
+        near = std::max(near, std::min(t0, t1));
+        far  = std::min(far,  std::max(t0, t1));
+    }
+    else if(::fabsf(axis.origin.y - _origin.y) > slab) {
+        return 1.0f;
+    }
+    if(near > far) {
+        return 1.0f;
+    }
+    const pos3f p0(axis.origin + (axis.direction * near));
+    const pos3f p1(axis.origin + (axis.direction * far));
+    const float spread  = _radius + (far * cone.tangent);
+    const int   col_min = std::max(static_cast<int>(::floorf(std::min(p0.x, p1.x) - spread - _origin.x)), 0);
+    const int   col_max = std::min(static_cast<int>(::ceilf (std::max(p0.x, p1.x) + spread - _origin.x)), (_cols - 1));
+    const int   row_min = std::max(static_cast<int>(::floorf(std::min(p0.z, p1.z) - spread - _origin.z)), 0);
+    const int   row_max = std::min(static_cast<int>(::ceilf (std::max(p0.z, p1.z) + spread - _origin.z)), (_rows - 1));
+
+    for(int row = row_min; row <= row_max; ++row) {
+        for(int col = col_min; col <= col_max; ++col) {
+            if(get(col, row) == false) {
+                continue;
+            }
+            visible *= (1.0f - cone.cover(get_center((row * _cols) + col), _radius));
+            if(visible <= 0.0f) {
+                return 0.0f;
+            }
+        }
+    }
+    return visible;
+}
+
+auto sphere_grid::occluder(const ray& ray, const float distance) const -> int
+{
+    int occluder = -1;
+
+    auto test = [&](const pos3f& center, const int primitive) -> bool
+    {
+        constexpr float distance_min = hit_result::DISTANCE_MIN;
+        const     float distance_max = distance;
+        const     float distance_hit = intersect(ray, center);
+        if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+            occluder = primitive;
+            return true;
+        }
+        return false;
+    };
+
+    static_cast<void>(walk(ray, distance, test));
+
+    return occluder;
+}
+
+bool sphere_grid::occludes(const ray& ray, const float distance, const int primitive) const
+{
+    constexpr float distance_min = hit_result::DISTANCE_MIN;
+    const     float distance_max = distance;
+    const     float distance_hit = intersect(ray, get_center(primitive));
+
+    return (distance_hit > distance_min) && (distance_hit < distance_max);
 }
 
-// ---------------------------------------------------------------------------
-// rt::cylinder
-// ---------------------------------------------------------------------------
+bool sphere_grid::bounds(box3f& box) const
+{
+    box = _bounds;
+
+    return true;
+}
+
+void sphere_grid::set(const int col, const int row)
+{
+    if((col < 0) || (col >= _cols) || (row < 0) || (row >= _rows)) {
+        throw std::runtime_error(std::string("rt::sphere_grid is unable to set") + ',' + ' ' + "out of bounds");
+    }
+    if(get(col, row) != false) {
+        return;
+    }
+    auto set_bit = [&](std::vector<uint64_t>& bits, const int bit_col, const int bit_row) -> void
+    {
+        bits[(bit_row * _stride) + (bit_col >> 6)] |= (uint64_t(1) << (bit_col & 63));
+    };
+
+    const int sphere_col = col + _reach;
+    const int sphere_row = row + _reach;
+    set_bit(_spheres, sphere_col, sphere_row);
+    for(int cell_row = sphere_row - _reach; cell_row <= sphere_row + _reach; ++cell_row) {
+        for(int cell_col = sphere_col - _reach; cell_col <= sphere_col + _reach; ++cell_col) {
+            set_bit(_cells, cell_col, cell_row);
+        }
+    }
+    /* enlarge the bounds to the new sphere */ {
+        const vec3f radius(_radius, _radius, _radius);
+        const pos3f center ( _origin.x + static_cast<float>(col)
+                           , _origin.y
+                           , _origin.z + static_cast<float>(row) );
+        _bounds += (center - radius);
+        _bounds += (center + radius);
+    }
+    ++_count;
+}
+
+bool sphere_grid::get(const int col, const int row) const
+{
+    if((col < 0) || (col >= _cols) || (row < 0) || (row >= _rows)) {
+        return false;
+    }
+    return fetch(_spheres, col + _reach, row + _reach, 1) != 0;
+}
+
+auto sphere_grid::fetch(const std::vector<uint64_t>& bits, const int col, const int row, const int width) const -> uint64_t
+{
+    const int first = std::max(col, 0);
+    const int last  = std::min(col + width, _width);
+    if((row < 0) || (row >= _height) || (first >= last)) {
+        return 0;
+    }
+    const uint64_t* line  = &bits[row * _stride];
+    const int       word  = (first >> 6);
+    const int       shift = (first & 63);
+    uint64_t        value = (line[word] >> shift);
+    if((shift != 0) && ((word + 1) < _stride)) {
+        value |= (line[word + 1] << (64 - shift));
+    }
+    value &= ((uint64_t(1) << (last - first)) - 1);
+
+    return value << (first - col);
+}
+
+auto sphere_grid::next(const int col, const int row, const int step) const -> int
+{
+    const uint64_t* line = &_cells[row * _stride];
+
+    if(step > 0) {
+        const int first = col + 1;
+        if(first >= _width) {
+            return _width;
+        }
+        int      word  = (first >> 6);
+        uint64_t value = line[word] & (~uint64_t(0) << (first & 63));
+        while(value == 0) {
+            if(++word >= _stride) {
+                return _width;
+            }
+            value = line[word];
+        }
+        return std::min((word * 64) + __builtin_ctzll(value), _width);
+    }
+    else {
+        const int first = col - 1;
+        if(first < 0) {
+            return -1;
+        }
+        int      word  = (first >> 6);
+        uint64_t value = line[word] & (~uint64_t(0) >> (63 - (first & 63)));
+        while(value == 0) {
+            if(--word < 0) {
+                return -1;
+            }
+            value = line[word];
+        }
+        return (word * 64) + (63 - __builtin_clzll(value));
+    }
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere_lattice
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+/*
+ * the sphere centers of a world are laid out at compile time, so that the
+ * intersection loops run over constant arrays with a constant trip count
+ */
+template <typename World>
+constexpr auto lattice_size() -> int
+{
+    int size = 0;
+    for(int row = 0; row < World::rows(); ++row) {
+        size += __builtin_popcount(World::row(row));
+    }
+    return size;
+}
+
+template <typename World>
+struct lattice_layout
+{
+    static constexpr int SIZE = lattice_size<World>();
+
+    static_assert(SIZE > 0, "the world must not be empty");
+
+    float x[SIZE];
+    float z[SIZE];
+};
+
+template <typename World>
+constexpr auto lattice_build() -> lattice_layout<World>
+{
+    lattice_layout<World> layout {};
+    int                   index = 0;
+    for(int row = 0; row < World::rows(); ++row) {
+        for(int col = 0; col < World::cols(); ++col) {
+            if(((World::row(row) >> col) & 1) != 0) {
+                layout.x[index] = (World::col_offset() + 1.0f) + static_cast<float>((World::cols() - 1) - col);
+                layout.z[index] = (World::row_offset() + 1.0f) + static_cast<float>((World::rows() - 1) - row);
+                ++index;
+            }
+        }
+    }
+    return layout;
+}
+
+template <typename World>
+constexpr lattice_layout<World> lattice_spheres = lattice_build<World>();
+
+template <typename World>
+sphere_lattice<World>::sphere_lattice()
+    : object()
+{
+}
+
+template <typename World>
+bool sphere_lattice<World>::hit(const ray& ray, hit_record& record) const
+{
+    constexpr int   size   = lattice_layout<World>::SIZE;
+    constexpr float radius = World::sphere_radius();
+    const auto&     layout(lattice_spheres<World>);
+    float           distance  = record.distance;
+    int             primitive = -1;
+
+#pragma GCC unroll 64
+    for(int index = 0; index < size; ++index) {
+        const vec3f oc((ray.origin.x - layout.x[index]), (ray.origin.y - 0.0f), (ray.origin.z - layout.z[index]));
+        const float b = vec3f::dot(oc, ray.direction);
+        const float c = vec3f::dot(oc, oc) - (radius * radius);
+        const float delta = ((b * b) - c);
+        if(delta > 0.0f) {
+            constexpr float distance_min = hit_result::DISTANCE_MIN;
+            const     float distance_hit = (-b - ::sqrtf(delta));
+            if((distance_hit > distance_min) && (distance_hit < distance)) {
+                distance  = distance_hit;
+                primitive = index;
+            }
+        }
+    }
+    if(primitive >= 0) {
+        record.set(distance, hit_record::kind::object, this, primitive);
+        return true;
+    }
+    return false;
+}
+
+template <typename World>
+void sphere_lattice<World>::resolve(const ray& ray, const hit_record& record, const material& material, hit_result& result) const
+{
+    const auto& layout(lattice_spheres<World>);
+    const pos3f center(layout.x[record.primitive], 0.0f, layout.z[record.primitive]);
+    const vec3f oc(pos3f::difference(ray.origin, center));
+    const vec3f length(ray.direction * record.distance);
+    result.distance = record.distance;
+    result.position = pos3f(ray.origin + length);
+    result.normal   = vec3f(oc + length, true);
+    result.color    = material.color0;
+    result.reflect  = material.reflect;
+    result.refract  = material.refract;
+    result.eta      = material.eta;
+    result.specular = material.specular;
+}
+
+template <typename World>
+bool sphere_lattice<World>::occluded(const ray& ray, const float distance) const
+{
+    constexpr int   size   = lattice_layout<World>::SIZE;
+    constexpr float radius = World::sphere_radius();
+    const auto&     layout(lattice_spheres<World>);
+
+#pragma GCC unroll 64
+    for(int index = 0; index < size; ++index) {
+        const vec3f oc((ray.origin.x - layout.x[index]), (ray.origin.y - 0.0f), (ray.origin.z - layout.z[index]));
+        const float b = vec3f::dot(oc, ray.direction);
+        const float c = vec3f::dot(oc, oc) - (radius * radius);
+        const float delta = ((b * b) - c);
+        if(delta > 0.0f) {
+            constexpr float distance_min = hit_result::DISTANCE_MIN;
+            const     float distance_max = distance;
+            const     float distance_hit = (-b - ::sqrtf(delta));
+            if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+template <typename World>
+auto sphere_lattice<World>::visibility(const cone& cone) const -> float
+{
+    constexpr int   size   = lattice_layout<World>::SIZE;
+    constexpr float radius = World::sphere_radius();
+    const auto&     layout(lattice_spheres<World>);
+    float           visible = 1.0f;
+
+    for(int index = 0; index < size; ++index) {
+        const pos3f center(layout.x[index], 0.0f, layout.z[index]);
+        visible *= (1.0f - cone.cover(center, radius));
+        if(visible <= 0.0f) {
+            return 0.0f;
+        }
+    }
+    return visible;
+}
+
+template <typename World>
+bool sphere_lattice<World>::bounds(box3f& box) const
+{
+    constexpr int   size   = lattice_layout<World>::SIZE;
+    constexpr float radius = World::sphere_radius();
+    const auto&     layout(lattice_spheres<World>);
+    const vec3f     extent(radius, radius, radius);
+
+    box = box3f();
+    for(int index = 0; index < size; ++index) {
+        const pos3f center(layout.x[index], 0.0f, layout.z[index]);
+        box += (center - extent);
+        box += (center + extent);
+    }
+    return true;
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::cylinder
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+cylinder::cylinder ( const pos3f& cylinder_point1
+                   , const pos3f& cylinder_point2
+                   , const float  cylinder_radius )
+    : object()
+    , _point1(cylinder_point1)
+    , _point2(cylinder_point2)
+    , _radius(cylinder_radius)
+{
+}
+
+bool cylinder::hit(const ray& ray, hit_record& record) const
+{
+    return false;
+}
+
+void cylinder::resolve(const ray& ray, const hit_record& record, const material& material, hit_result& result) const
+{
+}
+
+bool cylinder::occluded(const ray& ray, const float distance) const
+{
+    return false;
+}
+
+bool cylinder::bounds(box3f& box) const
+{
+    const vec3f radius(_radius, _radius, _radius);
+
+    box = box3f();
+    box += (_point1 - radius);
+    box += (_point1 + radius);
+    box += (_point2 - radius);
+    box += (_point2 + radius);
+
+    return true;
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::bvh
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+bvh::bvh()
+    : _nodes()
+    , _indices()
+    , _leaf_size(1)
+    , _cost(0.0f)
+{
+}
+
+void bvh::build(const std::vector<box3f>& boxes, const int leaf_size, const int threads)
+{
+    const int count = static_cast<int>(boxes.size());
+
+    clear();
+    _leaf_size = std::max(leaf_size, 1);
+    if(count > 0) {
+        _nodes.reserve((2 * count) - 1);
+        _indices.resize(count);
+        for(int index = 0; index < count; ++index) {
+            _indices[index] = index;
+        }
+        static_cast<void>(build(boxes, _nodes, 0, count, 0, std::max(threads, 1)));
+    }
+    _cost = get_cost();
+}
+
+/*
+ * bottom-up refit in O(N), the children being stored after their parent
+ * the nodes are visited backwards, false is returned when the SAH cost has
+ * degraded past REFIT_MAX times the cost of the last build
+ */
+bool bvh::refit(const std::vector<box3f>& boxes)
+{
+    const int count = static_cast<int>(_nodes.size());
+
+    for(int index = count - 1; index >= 0; --index) {
+        node& current(_nodes[index]);
+        box3f bounds;
+        if(current.count > 0) {
+            const int last = current.index + current.count;
+            for(int primitive = current.index; primitive < last; ++primitive) {
+                bounds += boxes[_indices[primitive]];
+            }
+        }
+        else {
+            bounds += _nodes[index + 1].bounds;
+            bounds += _nodes[current.index].bounds;
+        }
+        current.bounds = bounds;
+    }
+    return get_cost() <= (_cost * REFIT_MAX);
+}
+
+void bvh::clear()
+{
+    std::vector<node>().swap(_nodes);
+    std::vector<int>().swap(_indices);
+    _cost = 0.0f;
+}
+
+/*
+ * the SAH cost of the whole tree relative to its root, with the same
+ * constants and leaf blocks as the builder
+ */
+auto bvh::get_cost() const -> float
+{
+    if(_nodes.empty()) {
+        return 0.0f;
+    }
+    const float root_area = std::max(_nodes.front().bounds.area(), FLT_MIN);
+    float       cost      = 0.0f;
+    for(auto& node : _nodes) {
+        const float area = node.bounds.area() / root_area;
+        if(node.count > 0) {
+            cost += COST_LEAF * area * static_cast<float>((node.count + _leaf_size - 1) / _leaf_size);
+        }
+        else {
+            cost += COST_NODE * area;
+        }
+    }
+    return cost;
+}
+
+bool bvh::enter ( const box3f& box
+                , const pos3f& origin
+                , const vec3f& inverse
+                , const float  distance_max
+                , float&       distance_hit )
+{
+    const float x1 = (box.min.x - origin.x) * inverse.x;
+    const float x2 = (box.max.x - origin.x) * inverse.x;
+    const float y1 = (box.min.y - origin.y) * inverse.y;
+    const float y2 = (box.max.y - origin.y) * inverse.y;
+    const float z1 = (box.min.z - origin.z) * inverse.z;
+    const float z2 = (box.max.z - origin.z) * inverse.z;
+    const float t1 = std::max(std::max(std::min(x1, x2), std::min(y1, y2)), std::max(std::min(z1, z2), 0.0f));
+    const float t2 = std::min(std::min(std::max(x1, x2), std::max(y1, y2)), std::min(std::max(z1, z2), distance_max));
+
+    if(t1 <= t2) {
+        distance_hit = t1;
+        return true;
+    }
+    return false;
+}
+
+/*
+ * a coherent packet is first culled as a whole with interval arithmetic on
+ * its origins and inverse directions, the surviving lanes are then tested
+ * one by one with the same slab test as the single rays (the loop runs over
+ * all the lanes of the SoA arrays so that it can be vectorized)
+ */
+auto bvh::enter ( const box3f&      box
+                , const ray_packet& packet
+                , const float*      distances
+                , const uint32_t    mask
+                , float&            distance_hit ) -> uint32_t
+{
+    constexpr int LANES = ray_packet::LANES_MAX;
+
+    auto interval = [](const float plane, const float origin_min, const float origin_max, const float inverse_min, const float inverse_max, float& lower, float& upper) -> void
+    {
+        const float p1 = (plane - origin_max) * inverse_min;
+        const float p2 = (plane - origin_max) * inverse_max;
+        const float p3 = (plane - origin_min) * inverse_min;
+        const float p4 = (plane - origin_min) * inverse_max;
+        lower = std::min(std::min(p1, p2), std::min(p3, p4));
+        upper = std::max(std::max(p1, p2), std::max(p3, p4));
+    };
+
+    auto culled = [&]() -> bool
+    {
+        if(packet.coherent() == false) {
+            return false;
+        }
+        const pos3f& o1(packet.origins.min);
+        const pos3f& o2(packet.origins.max);
+        const pos3f& i1(packet.inverses.min);
+        const pos3f& i2(packet.inverses.max);
+        float x1, x2, x3, x4, y1, y2, y3, y4, z1, z2, z3, z4;
+        interval(box.min.x, o1.x, o2.x, i1.x, i2.x, x1, x2);
+        interval(box.max.x, o1.x, o2.x, i1.x, i2.x, x3, x4);
+        interval(box.min.y, o1.y, o2.y, i1.y, i2.y, y1, y2);
+        interval(box.max.y, o1.y, o2.y, i1.y, i2.y, y3, y4);
+        interval(box.min.z, o1.z, o2.z, i1.z, i2.z, z1, z2);
+        interval(box.max.z, o1.z, o2.z, i1.z, i2.z, z3, z4);
+        float distance_max = 0.0f;
+        for(int lane = 0; lane < packet.size(); ++lane) {
+            distance_max = std::max(distance_max, distances[lane]);
+        }
+        const float tx1 = (i1.x > 0.0f ? x1 : x3);
+        const float tx2 = (i1.x > 0.0f ? x4 : x2);
+        const float ty1 = (i1.y > 0.0f ? y1 : y3);
+        const float ty2 = (i1.y > 0.0f ? y4 : y2);
+        const float tz1 = (i1.z > 0.0f ? z1 : z3);
+        const float tz2 = (i1.z > 0.0f ? z4 : z2);
+        const float t1  = std::max(std::max(tx1, ty1), std::max(tz1, 0.0f));
+        const float t2  = std::min(std::min(tx2, ty2), std::min(tz2, distance_max));
+        return (t1 > t2);
+    };
+
+    auto lanes = [&]() -> uint32_t
+    {
+        alignas(64) float t1[LANES];
+        alignas(64) float t2[LANES];
+        for(int lane = 0; lane < LANES; ++lane) {
+            const float x1 = (box.min.x - packet.ox[lane]) * packet.ix[lane];
+            const float x2 = (box.max.x - packet.ox[lane]) * packet.ix[lane];
+            const float y1 = (box.min.y - packet.oy[lane]) * packet.iy[lane];
+            const float y2 = (box.max.y - packet.oy[lane]) * packet.iy[lane];
+            const float z1 = (box.min.z - packet.oz[lane]) * packet.iz[lane];
+            const float z2 = (box.max.z - packet.oz[lane]) * packet.iz[lane];
+            t1[lane] = std::max(std::max(std::min(x1, x2), std::min(y1, y2)), std::max(std::min(z1, z2), 0.0f));
+            t2[lane] = std::min(std::min(std::max(x1, x2), std::max(y1, y2)), std::min(std::max(z1, z2), distances[lane]));
+        }
+        uint32_t hits = 0;
+        distance_hit = FLT_MAX;
+        for(int lane = 0; lane < LANES; ++lane) {
+            const uint32_t bit = (UINT32_C(1) << lane);
+            if(((mask & bit) != 0) && (t1[lane] <= t2[lane])) {
+                hits |= bit;
+                distance_hit = std::min(distance_hit, t1[lane]);
+            }
+        }
+        return hits;
+    };
+
+    auto execute = [&]() -> uint32_t
+    {
+        if(culled()) {
+            return 0;
+        }
+        return lanes();
+    };
+
+    return execute();
+}
+
+/*
+ * the nodes are laid out depth first, the left child following its parent
+ * and the parent holding the index of its right child, large ranges being
+ * binned and split across the available threads
+ */
+int bvh::build(const std::vector<box3f>& boxes, std::vector<node>& nodes, const int first, const int count, const int depth, const int threads)
+{
+    const int index    = static_cast<int>(nodes.size());
+    auto      begin    = _indices.begin() + first;
+    auto      end      = _indices.begin() + first + count;
+    const int parallel = ((count >= PARALLEL_MIN) ? std::min(threads, (count / (PARALLEL_MIN / 4))) : 1);
+
+    struct bin
+    {
+        box3f bounds;
+        box3f centers;
+        int   count;
+    };
+
+    auto coord = [](const pos3f& position, const int axis) -> float
+    {
+        return (axis == 0 ? position.x : axis == 1 ? position.y : position.z);
+    };
+
+    auto sort = [&](const int axis) -> void
+    {
+        auto compare = [&](const int lhs, const int rhs) -> bool
+        {
+            const float lhs_coord = coord(boxes[lhs].center(), axis);
+            const float rhs_coord = coord(boxes[rhs].center(), axis);
+            if(lhs_coord != rhs_coord) {
+                return lhs_coord < rhs_coord;
+            }
+            return lhs < rhs;
+        };
+        std::sort(begin, end, compare);
+    };
+
+    auto blocks = [&](const int primitives) -> float
+    {
+        return static_cast<float>((primitives + _leaf_size - 1) / _leaf_size);
+    };
+
+    auto for_each_task = [&](const int tasks, auto&& function) -> void
+    {
+        std::vector<std::thread> workers;
+        for(int task = 1; task < tasks; ++task) {
+            workers.emplace_back([&, task]() -> void { function(task, (first + ((count * static_cast<int64_t>(task)) / tasks)), (first + ((count * static_cast<int64_t>(task + 1)) / tasks))); });
+        }
+        function(0, first, (first + (count / tasks)));
+        for(auto& worker : workers) {
+            worker.join();
+        }
+    };
+
+    /* node bounds and centroid bounds, one partial result per task */
+    box3f bounds;
+    box3f centers;
+    {
+        std::vector<bin> partials(parallel);
+        for_each_task(parallel, [&](const int task, const int lower, const int upper) -> void
+        {
+            bin& partial(partials[task]);
+            for(int it = lower; it < upper; ++it) {
+                partial.bounds  += boxes[_indices[it]];
+                partial.centers += boxes[_indices[it]].center();
+            }
+        });
+        for(auto& partial : partials) {
+            bounds  += partial.bounds;
+            centers += partial.centers;
+        }
+    }
+    nodes.push_back(node { bounds, first, count });
+    if(count <= 1) {
+        return index;
+    }
+
+    const float bounds_area = std::max(bounds.area(), FLT_MIN);
+    float       best_cost   = COST_LEAF * blocks(count);
+    int         best_axis   = -1;
+    int         best_split  = 0;
+    bool        partitioned = false;
+
+    /*
+     * full sweep SAH over the three axes, the leaf cost being the reference,
+     * primitives being tested by blocks of leaf size (the SIMD width)
+     */
+    auto split_sweep = [&]() -> void
+    {
+        std::vector<float> right_areas(count);
+        for(int axis = 0; axis < 3; ++axis) {
+            sort(axis);
+            box3f right;
+            for(int split = count - 1; split > 0; --split) {
+                right += boxes[begin[split]];
+                right_areas[split] = right.area();
+            }
+            box3f left;
+            for(int split = 1; split < count; ++split) {
+                left += boxes[begin[split - 1]];
+                const float left_cost  = left.area() * blocks(split);
+                const float right_cost = right_areas[split] * blocks(count - split);
+                const float cost       = COST_NODE + COST_LEAF * ((left_cost + right_cost) / bounds_area);
+                if(cost < best_cost) {
+                    best_cost  = cost;
+                    best_axis  = axis;
+                    best_split = split;
+                }
+            }
+        }
+        if(best_axis >= 0) {
+            if(best_axis != 2) {
+                sort(best_axis);
+            }
+            partitioned = true;
+        }
+    };
+
+    /*
+     * binned SAH over the centroid bounds, each task fills its own bins
+     * which are then summed and swept by prefix and suffix
+     */
+    auto split_binned = [&]() -> void
+    {
+        const vec3f extent(pos3f::difference(centers.max, centers.min));
+        const float scales[3] = {
+            (extent.x > 0.0f ? (BINS_COUNT * 0.999f) / extent.x : 0.0f),
+            (extent.y > 0.0f ? (BINS_COUNT * 0.999f) / extent.y : 0.0f),
+            (extent.z > 0.0f ? (BINS_COUNT * 0.999f) / extent.z : 0.0f),
+        };
+
+        auto get_bin = [&](const int primitive, const int axis) -> int
+        {
+            const float offset = coord(boxes[primitive].center(), axis) - coord(centers.min, axis);
+            return std::min(std::max(static_cast<int>(offset * scales[axis]), 0), (BINS_COUNT - 1));
+        };
+
+        std::vector<bin> bins(parallel * 3 * BINS_COUNT, bin { box3f(), box3f(), 0 });
+        for_each_task(parallel, [&](const int task, const int lower, const int upper) -> void
+        {
+            bin* partial = &bins[task * 3 * BINS_COUNT];
+            for(int it = lower; it < upper; ++it) {
+                const int primitive = _indices[it];
+                for(int axis = 0; axis < 3; ++axis) {
+                    bin& target(partial[(axis * BINS_COUNT) + get_bin(primitive, axis)]);
+                    target.bounds += boxes[primitive];
+                    target.count  += 1;
+                }
+            }
+        });
+        for(int task = 1; task < parallel; ++task) {
+            for(int slot = 0; slot < (3 * BINS_COUNT); ++slot) {
+                bin& target(bins[slot]);
+                bin& source(bins[(task * 3 * BINS_COUNT) + slot]);
+                target.bounds += source.bounds;
+                target.count  += source.count;
+            }
+        }
+
+        int best_bin = 0;
+        for(int axis = 0; axis < 3; ++axis) {
+            if(scales[axis] == 0.0f) {
+                continue;
+            }
+            const bin* axis_bins = &bins[axis * BINS_COUNT];
+            float      right_areas[BINS_COUNT];
+            int        right_counts[BINS_COUNT];
+            box3f      right;
+            int        right_count = 0;
+            for(int split = BINS_COUNT - 1; split > 0; --split) {
+                right       += axis_bins[split].bounds;
+                right_count += axis_bins[split].count;
+                right_areas[split]  = right.area();
+                right_counts[split] = right_count;
+            }
+            box3f left;
+            int   left_count = 0;
+            for(int split = 1; split < BINS_COUNT; ++split) {
+                left       += axis_bins[split - 1].bounds;
+                left_count += axis_bins[split - 1].count;
+                if((left_count == 0) || (right_counts[split] == 0)) {
+                    continue;
+                }
+                const float left_cost  = left.area() * blocks(left_count);
+                const float right_cost = right_areas[split] * blocks(right_counts[split]);
+                const float cost       = COST_NODE + COST_LEAF * ((left_cost + right_cost) / bounds_area);
+                if(cost < best_cost) {
+                    best_cost  = cost;
+                    best_axis  = axis;
+                    best_bin   = split;
+                    best_split = left_count;
+                }
+            }
+        }
+        if(best_axis >= 0) {
+            static_cast<void>(std::partition(begin, end, [&](const int primitive) -> bool
+            {
+                return get_bin(primitive, best_axis) < best_bin;
+            }));
+            partitioned = true;
+        }
+    };
+
+    /*
+     * keep a leaf when splitting does not pay, fallback to a median split
+     * along the largest centroid extent when the leaf is too large or when
+     * the tree becomes too deep
+     */
+    auto split_median = [&]() -> bool
+    {
+        if(count <= (LEAF_MAX * _leaf_size)) {
+            return false;
+        }
+        const vec3f extent(pos3f::difference(centers.max, centers.min));
+        best_axis  = (extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2));
+        best_split = (count / 2);
+        if(count <= SWEEP_MAX) {
+            sort(best_axis);
+        }
+        else {
+            std::nth_element(begin, (begin + best_split), end, [&](const int lhs, const int rhs) -> bool
+            {
+                return coord(boxes[lhs].center(), best_axis) < coord(boxes[rhs].center(), best_axis);
+            });
+        }
+        return true;
+    };
+
+    auto split_children = [&]() -> int
+    {
+        if(parallel > 1) {
+            std::vector<node> left_nodes;
+            std::vector<node> right_nodes;
+            const int         left_threads = (threads / 2);
+            std::thread       worker([&]() -> void
+            {
+                static_cast<void>(build(boxes, left_nodes, first, best_split, depth + 1, left_threads));
+            });
+            static_cast<void>(build(boxes, right_nodes, first + best_split, count - best_split, depth + 1, threads - left_threads));
+            worker.join();
+            auto append = [&](const std::vector<node>& subtree) -> int
+            {
+                const int offset = static_cast<int>(nodes.size());
+                for(auto& node : subtree) {
+                    nodes.push_back(node);
+                    if(node.count == 0) {
+                        nodes.back().index += offset;
+                    }
+                }
+                return offset;
+            };
+            static_cast<void>(append(left_nodes));
+            return append(right_nodes);
+        }
+        static_cast<void>(build(boxes, nodes, first, best_split, depth + 1, threads));
+        return build(boxes, nodes, first + best_split, count - best_split, depth + 1, threads);
+    };
+
+    if(depth < (DEPTH_MAX / 2)) {
+        if(count <= SWEEP_MAX) {
+            split_sweep();
+        }
+        else {
+            split_binned();
+        }
+    }
+    if(partitioned == false) {
+        if(split_median() == false) {
+            return index;
+        }
+    }
+
+    const int right = split_children();
+    nodes[index].index = right;
+    nodes[index].count = 0;
+
+    return index;
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::bvh traversal
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+template <typename Function>
+void bvh::closest(const ray& ray, const vec3f& inverse, const float& distance, Function&& function) const
+{
+    struct entry
+    {
+        int   index;
+        float distance;
+    };
+
+    if(_nodes.empty()) {
+        return;
+    }
+
+    entry stack[DEPTH_MAX];
+    int   top = 0;
+    float distance_hit = 0.0f;
+
+    if(enter(_nodes[0].bounds, ray.origin, inverse, distance, distance_hit)) {
+        stack[top++] = entry { 0, distance_hit };
+    }
+    while(top > 0) {
+        const entry current(stack[--top]);
+        if(current.distance > distance) {
+            continue;
+        }
+        int index = current.index;
+        while(true) {
+            const node& branch(_nodes[index]);
+            if(branch.count > 0) {
+                function(branch.index, branch.count);
+                break;
+            }
+            const int  left  = index + 1;
+            const int  right = branch.index;
+            float      left_distance  = 0.0f;
+            float      right_distance = 0.0f;
+            const bool left_hit  = enter(_nodes[left ].bounds, ray.origin, inverse, distance, left_distance);
+            const bool right_hit = enter(_nodes[right].bounds, ray.origin, inverse, distance, right_distance);
+            if(left_hit && right_hit) {
+                if(left_distance <= right_distance) {
+                    stack[top++] = entry { right, right_distance };
+                    index = left;
+                }
+                else {
+                    stack[top++] = entry { left, left_distance };
+                    index = right;
+                }
+            }
+            else if(left_hit) {
+                index = left;
+            }
+            else if(right_hit) {
+                index = right;
+            }
+            else {
+                break;
+            }
+        }
+    }
+}
+
+template <typename Function>
+bool bvh::any(const ray& ray, const vec3f& inverse, const float distance, Function&& function) const
+{
+    if(_nodes.empty()) {
+        return false;
+    }
+
+    int   stack[DEPTH_MAX];
+    int   top = 0;
+    float distance_hit = 0.0f;
+
+    if(enter(_nodes[0].bounds, ray.origin, inverse, distance, distance_hit)) {
+        stack[top++] = 0;
+    }
+    while(top > 0) {
+        const int   index = stack[--top];
+        const node& branch(_nodes[index]);
+        if(branch.count > 0) {
+            if(function(branch.index, branch.count)) {
+                return true;
+            }
+            continue;
+        }
+        const int left  = index + 1;
+        const int right = branch.index;
+        if(enter(_nodes[right].bounds, ray.origin, inverse, distance, distance_hit)) {
+            stack[top++] = right;
+        }
+        if(enter(_nodes[left].bounds, ray.origin, inverse, distance, distance_hit)) {
+            stack[top++] = left;
+        }
+    }
+    return false;
+}
+
+/*
+ * generic traversal, the nodes whose bounds pass the predicate being
+ * entered and their leaves given to the function until it returns true
+ */
+template <typename Predicate, typename Function>
+bool bvh::visit(Predicate&& predicate, Function&& function) const
+{
+    if(_nodes.empty()) {
+        return false;
+    }
+
+    int stack[DEPTH_MAX];
+    int top = 0;
+
+    if(predicate(_nodes[0].bounds)) {
+        stack[top++] = 0;
+    }
+    while(top > 0) {
+        const int   index = stack[--top];
+        const node& branch(_nodes[index]);
+        if(branch.count > 0) {
+            if(function(branch.index, branch.count)) {
+                return true;
+            }
+            continue;
+        }
+        const int left  = index + 1;
+        const int right = branch.index;
+        if(predicate(_nodes[right].bounds)) {
+            stack[top++] = right;
+        }
+        if(predicate(_nodes[left].bounds)) {
+            stack[top++] = left;
+        }
+    }
+    return false;
+}
+
+/*
+ * packet traversal, each node carries the mask of the lanes still entering
+ * it, the divergent lanes being masked out as the packet goes down the tree
+ */
+template <typename Function>
+void bvh::closest(const ray_packet& packet, const float* distances, Function&& function) const
+{
+    struct entry
+    {
+        int      index;
+        uint32_t mask;
+    };
+
+    if(_nodes.empty()) {
+        return;
+    }
+
+    entry stack[DEPTH_MAX];
+    int   top = 0;
+    float distance_hit = 0.0f;
+
+    stack[top++] = entry { 0, packet.mask() };
+    while(top > 0) {
+        const entry current(stack[--top]);
+        int      index = current.index;
+        uint32_t mask  = enter(_nodes[index].bounds, packet, distances, current.mask, distance_hit);
+        if(mask == 0) {
+            continue;
+        }
+        while(true) {
+            const node& branch(_nodes[index]);
+            if(branch.count > 0) {
+                function(branch.index, branch.count, mask);
+                break;
+            }
+            const int      left  = index + 1;
+            const int      right = branch.index;
+            float          left_distance  = 0.0f;
+            float          right_distance = 0.0f;
+            const uint32_t left_mask  = enter(_nodes[left ].bounds, packet, distances, mask, left_distance);
+            const uint32_t right_mask = enter(_nodes[right].bounds, packet, distances, mask, right_distance);
+            if((left_mask != 0) && (right_mask != 0)) {
+                if(left_distance <= right_distance) {
+                    stack[top++] = entry { right, right_mask };
+                    index = left;
+                    mask  = left_mask;
+                }
+                else {
+                    stack[top++] = entry { left, left_mask };
+                    index = right;
+                    mask  = right_mask;
+                }
+            }
+            else if(left_mask != 0) {
+                index = left;
+                mask  = left_mask;
+            }
+            else if(right_mask != 0) {
+                index = right;
+                mask  = right_mask;
+            }
+            else {
+                break;
+            }
+        }
+    }
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere_array
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+sphere_array::sphere_array()
+    : x()
+    , y()
+    , z()
+    , radius()
+    , material()
+{
+}
+
+void sphere_array::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+    material.clear();
+}
+
+void sphere_array::add(const pos3f& sphere_center, const float sphere_radius, const int sphere_material)
+{
+    x.push_back(sphere_center.x);
+    y.push_back(sphere_center.y);
+    z.push_back(sphere_center.z);
+    radius.push_back(sphere_radius);
+    material.push_back(sphere_material);
+}
+
+void sphere_array::permute(const std::vector<int>& indices)
+{
+    sphere_array other;
+
+    for(auto& index : indices) {
+        other.add(pos3f(x[index], y[index], z[index]), radius[index], material[index]);
+    }
+    x.swap(other.x);
+    y.swap(other.y);
+    z.swap(other.z);
+    radius.swap(other.radius);
+    material.swap(other.material);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere_kernel
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+/*
+ * every kernel evaluates the simplified analytic formula of sphere::hit
+ * with the very same sequence of operations (no FMA contraction), so the
+ * vector lanes and the scalar tail produce bit-identical distances, ties
+ * being resolved in favor of the lowest index like the scalar loop does
+ */
+
+auto sphere_kernel::lanes() -> int
+{
+    switch(get_level()) {
+        case level::avx512:
+            return 16;
+        case level::avx2:
+            return 8;
+        default:
+            break;
+    }
+    return 1;
+}
+
+auto sphere_kernel::closest ( const sphere_array& spheres
+                            , const ray&          ray
+                            , const int           first
+                            , const int           count
+                            , float&              distance ) -> int
+{
+    switch(get_level()) {
+        case level::avx512:
+            return closest_avx512(spheres, ray, first, first + count, distance);
+        case level::avx2:
+            return closest_avx2(spheres, ray, first, first + count, distance);
+        default:
+            break;
+    }
+    return closest_scalar(spheres, ray, first, first + count, distance);
+}
+
+bool sphere_kernel::any ( const sphere_array& spheres
+                        , const ray&          ray
+                        , const int           first
+                        , const int           count
+                        , const float         distance )
+{
+    switch(get_level()) {
+        case level::avx512:
+            return any_avx512(spheres, ray, first, first + count, distance);
+        case level::avx2:
+            return any_avx2(spheres, ray, first, first + count, distance);
+        default:
+            break;
+    }
+    return any_scalar(spheres, ray, first, first + count, distance);
+}
+
+auto sphere_kernel::get_level() -> level
+{
+    auto detect = []() -> level
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f")) {
+            return level::avx512;
+        }
+        if(__builtin_cpu_supports("avx2")) {
+            return level::avx2;
+        }
+#endif
+        return level::scalar;
+    };
+
+    static const level value = detect();
+
+    return value;
+}
+
+auto sphere_kernel::closest_scalar(const sphere_array& spheres, const ray& ray, const int first, const int last, float& distance) -> int
+{
+    const float* sx = spheres.x.data();
+    const float* sy = spheres.y.data();
+    const float* sz = spheres.z.data();
+    const float* sr = spheres.radius.data();
+    int          closest = -1;
+
+    for(int index = first; index < last; ++index) {
+        const vec3f oc ( (ray.origin.x - sx[index])
+                       , (ray.origin.y - sy[index])
+                       , (ray.origin.z - sz[index]) );
+        const float b = vec3f::dot(oc, ray.direction);
+        const float c = vec3f::dot(oc, oc) - (sr[index] * sr[index]);
+        const float delta = ((b * b) - c);
+        if(delta > 0.0f) {
+            constexpr float distance_min = hit_result::DISTANCE_MIN;
+            const     float distance_max = distance;
+            const     float distance_hit = (-b - ::sqrtf(delta));
+            if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+                distance = distance_hit;
+                closest  = index;
+            }
+        }
+    }
+    return closest;
+}
+
+bool sphere_kernel::any_scalar(const sphere_array& spheres, const ray& ray, const int first, const int last, const float distance)
+{
+    const float* sx = spheres.x.data();
+    const float* sy = spheres.y.data();
+    const float* sz = spheres.z.data();
+    const float* sr = spheres.radius.data();
+
+    for(int index = first; index < last; ++index) {
+        const vec3f oc ( (ray.origin.x - sx[index])
+                       , (ray.origin.y - sy[index])
+                       , (ray.origin.z - sz[index]) );
+        const float b = vec3f::dot(oc, ray.direction);
+        const float c = vec3f::dot(oc, oc) - (sr[index] * sr[index]);
+        const float delta = ((b * b) - c);
+        if(delta > 0.0f) {
+            constexpr float distance_min = hit_result::DISTANCE_MIN;
+            const     float distance_max = distance;
+            const     float distance_hit = (-b - ::sqrtf(delta));
+            if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+auto sphere_kernel::closest_avx2(const sphere_array& spheres, const ray& ray, const int first, const int last, float& distance) -> int
+{
+    const float* sx = spheres.x.data();
+    const float* sy = spheres.y.data();
+    const float* sz = spheres.z.data();
+    const float* sr = spheres.radius.data();
+    const __m256 ox = _mm256_set1_ps(ray.origin.x);
+    const __m256 oy = _mm256_set1_ps(ray.origin.y);
+    const __m256 oz = _mm256_set1_ps(ray.origin.z);
+    const __m256 dx = _mm256_set1_ps(ray.direction.x);
+    const __m256 dy = _mm256_set1_ps(ray.direction.y);
+    const __m256 dz = _mm256_set1_ps(ray.direction.z);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 none = _mm256_set1_ps(FLT_MAX);
+    const __m256 distance_min = _mm256_set1_ps(hit_result::DISTANCE_MIN);
+    __m256       distance_max = _mm256_set1_ps(distance);
+    int          closest = -1;
+    int          index   = first;
+
+    for(; (index + 8) <= last; index += 8) {
+        const __m256 ocx = _mm256_sub_ps(ox, _mm256_loadu_ps(sx + index));
+        const __m256 ocy = _mm256_sub_ps(oy, _mm256_loadu_ps(sy + index));
+        const __m256 ocz = _mm256_sub_ps(oz, _mm256_loadu_ps(sz + index));
+        const __m256 rad = _mm256_loadu_ps(sr + index);
+        const __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)), _mm256_mul_ps(ocz, dz));
+        const __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)), _mm256_mul_ps(rad, rad));
+        const __m256 delta = _mm256_sub_ps(_mm256_mul_ps(b, b), c);
+        const __m256 distance_hit = _mm256_sub_ps(_mm256_xor_ps(b, sign), _mm256_sqrt_ps(delta));
+        const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(delta, zero, _CMP_GT_OQ)
+                           , _mm256_and_ps(_mm256_cmp_ps(distance_hit, distance_min, _CMP_GT_OQ)
+                                         , _mm256_cmp_ps(distance_hit, distance_max, _CMP_LT_OQ)));
+        if(_mm256_movemask_ps(valid) != 0) {
+            const __m256 candidates = _mm256_blendv_ps(none, distance_hit, valid);
+            __m256       minimum = _mm256_min_ps(candidates, _mm256_permute2f128_ps(candidates, candidates, 1));
+            minimum = _mm256_min_ps(minimum, _mm256_shuffle_ps(minimum, minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+            minimum = _mm256_min_ps(minimum, _mm256_shuffle_ps(minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+            const int lanes = _mm256_movemask_ps(_mm256_and_ps(valid, _mm256_cmp_ps(candidates, minimum, _CMP_EQ_OQ)));
+            distance     = _mm256_cvtss_f32(minimum);
+            distance_max = minimum;
+            closest      = index + __builtin_ctz(lanes);
+        }
+    }
+    if(index < last) {
+        const int tail = closest_scalar(spheres, ray, index, last, distance);
+        if(tail >= 0) {
+            closest = tail;
+        }
+    }
+    return closest;
+}
+
+__attribute__((target("avx2")))
+bool sphere_kernel::any_avx2(const sphere_array& spheres, const ray& ray, const int first, const int last, const float distance)
+{
+    const float* sx = spheres.x.data();
+    const float* sy = spheres.y.data();
+    const float* sz = spheres.z.data();
+    const float* sr = spheres.radius.data();
+    const __m256 ox = _mm256_set1_ps(ray.origin.x);
+    const __m256 oy = _mm256_set1_ps(ray.origin.y);
+    const __m256 oz = _mm256_set1_ps(ray.origin.z);
+    const __m256 dx = _mm256_set1_ps(ray.direction.x);
+    const __m256 dy = _mm256_set1_ps(ray.direction.y);
+    const __m256 dz = _mm256_set1_ps(ray.direction.z);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 distance_min = _mm256_set1_ps(hit_result::DISTANCE_MIN);
+    const __m256 distance_max = _mm256_set1_ps(distance);
+    int          index = first;
+
+    for(; (index + 8) <= last; index += 8) {
+        const __m256 ocx = _mm256_sub_ps(ox, _mm256_loadu_ps(sx + index));
+        const __m256 ocy = _mm256_sub_ps(oy, _mm256_loadu_ps(sy + index));
+        const __m256 ocz = _mm256_sub_ps(oz, _mm256_loadu_ps(sz + index));
+        const __m256 rad = _mm256_loadu_ps(sr + index);
+        const __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)), _mm256_mul_ps(ocz, dz));
+        const __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)), _mm256_mul_ps(rad, rad));
+        const __m256 delta = _mm256_sub_ps(_mm256_mul_ps(b, b), c);
+        const __m256 distance_hit = _mm256_sub_ps(_mm256_xor_ps(b, sign), _mm256_sqrt_ps(delta));
+        const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(delta, zero, _CMP_GT_OQ)
+                           , _mm256_and_ps(_mm256_cmp_ps(distance_hit, distance_min, _CMP_GT_OQ)
+                                         , _mm256_cmp_ps(distance_hit, distance_max, _CMP_LT_OQ)));
+        if(_mm256_movemask_ps(valid) != 0) {
+            return true;
+        }
+    }
+    return any_scalar(spheres, ray, index, last, distance);
+}
+
+__attribute__((target("avx512f")))
+auto sphere_kernel::closest_avx512(const sphere_array& spheres, const ray& ray, const int first, const int last, float& distance) -> int
+{
+    const float* sx = spheres.x.data();
+    const float* sy = spheres.y.data();
+    const float* sz = spheres.z.data();
+    const float* sr = spheres.radius.data();
+    const __m512 ox = _mm512_set1_ps(ray.origin.x);
+    const __m512 oy = _mm512_set1_ps(ray.origin.y);
+    const __m512 oz = _mm512_set1_ps(ray.origin.z);
+    const __m512 dx = _mm512_set1_ps(ray.direction.x);
+    const __m512 dy = _mm512_set1_ps(ray.direction.y);
+    const __m512 dz = _mm512_set1_ps(ray.direction.z);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 none = _mm512_set1_ps(FLT_MAX);
+    const __m512 distance_min = _mm512_set1_ps(hit_result::DISTANCE_MIN);
+    __m512       distance_max = _mm512_set1_ps(distance);
+    int          closest = -1;
+    int          index   = first;
+
+    for(; (index + 16) <= last; index += 16) {
+        const __m512 ocx = _mm512_sub_ps(ox, _mm512_loadu_ps(sx + index));
+        const __m512 ocy = _mm512_sub_ps(oy, _mm512_loadu_ps(sy + index));
+        const __m512 ocz = _mm512_sub_ps(oz, _mm512_loadu_ps(sz + index));
+        const __m512 rad = _mm512_loadu_ps(sr + index);
+        const __m512 b = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ocx, dx), _mm512_mul_ps(ocy, dy)), _mm512_mul_ps(ocz, dz));
+        const __m512 c = _mm512_sub_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ocx, ocx), _mm512_mul_ps(ocy, ocy)), _mm512_mul_ps(ocz, ocz)), _mm512_mul_ps(rad, rad));
+        const __m512 delta = _mm512_sub_ps(_mm512_mul_ps(b, b), c);
+        const __m512 distance_hit = _mm512_sub_ps(_mm512_sub_ps(zero, b), _mm512_maskz_sqrt_ps(0xffff, delta));
+        const __mmask16 valid = _mm512_cmp_ps_mask(delta, zero, _CMP_GT_OQ)
+                              & _mm512_cmp_ps_mask(distance_hit, distance_min, _CMP_GT_OQ)
+                              & _mm512_cmp_ps_mask(distance_hit, distance_max, _CMP_LT_OQ);
+        if(valid != 0) {
+            const __m512 candidates = _mm512_mask_blend_ps(valid, none, distance_hit);
+            __m512       minimum    = _mm512_maskz_min_ps(0xffff, candidates, _mm512_maskz_shuffle_f32x4(0xffff, candidates, candidates, _MM_SHUFFLE(1, 0, 3, 2)));
+            minimum = _mm512_maskz_min_ps(0xffff, minimum, _mm512_maskz_shuffle_f32x4(0xffff, minimum, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+            minimum = _mm512_maskz_min_ps(0xffff, minimum, _mm512_maskz_permute_ps(0xffff, minimum, _MM_SHUFFLE(1, 0, 3, 2)));
+            minimum = _mm512_maskz_min_ps(0xffff, minimum, _mm512_maskz_permute_ps(0xffff, minimum, _MM_SHUFFLE(2, 3, 0, 1)));
+            const __mmask16 lanes = valid & _mm512_cmp_ps_mask(candidates, minimum, _CMP_EQ_OQ);
+            distance     = _mm512_cvtss_f32(minimum);
+            distance_max = minimum;
+            closest  = index + __builtin_ctz(lanes);
+        }
+    }
+    if(index < last) {
+        const int tail = closest_scalar(spheres, ray, index, last, distance);
+        if(tail >= 0) {
+            closest = tail;
+        }
+    }
+    return closest;
+}
+
+__attribute__((target("avx512f")))
+bool sphere_kernel::any_avx512(const sphere_array& spheres, const ray& ray, const int first, const int last, const float distance)
+{
+    const float* sx = spheres.x.data();
+    const float* sy = spheres.y.data();
+    const float* sz = spheres.z.data();
+    const float* sr = spheres.radius.data();
+    const __m512 ox = _mm512_set1_ps(ray.origin.x);
+    const __m512 oy = _mm512_set1_ps(ray.origin.y);
+    const __m512 oz = _mm512_set1_ps(ray.origin.z);
+    const __m512 dx = _mm512_set1_ps(ray.direction.x);
+    const __m512 dy = _mm512_set1_ps(ray.direction.y);
+    const __m512 dz = _mm512_set1_ps(ray.direction.z);
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 distance_min = _mm512_set1_ps(hit_result::DISTANCE_MIN);
+    const __m512 distance_max = _mm512_set1_ps(distance);
+    int          index = first;
+
+    for(; (index + 16) <= last; index += 16) {
+        const __m512 ocx = _mm512_sub_ps(ox, _mm512_loadu_ps(sx + index));
+        const __m512 ocy = _mm512_sub_ps(oy, _mm512_loadu_ps(sy + index));
+        const __m512 ocz = _mm512_sub_ps(oz, _mm512_loadu_ps(sz + index));
+        const __m512 rad = _mm512_loadu_ps(sr + index);
+        const __m512 b = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ocx, dx), _mm512_mul_ps(ocy, dy)), _mm512_mul_ps(ocz, dz));
+        const __m512 c = _mm512_sub_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ocx, ocx), _mm512_mul_ps(ocy, ocy)), _mm512_mul_ps(ocz, ocz)), _mm512_mul_ps(rad, rad));
+        const __m512 delta = _mm512_sub_ps(_mm512_mul_ps(b, b), c);
+        const __m512 distance_hit = _mm512_sub_ps(_mm512_sub_ps(zero, b), _mm512_maskz_sqrt_ps(0xffff, delta));
+        const __mmask16 valid = _mm512_cmp_ps_mask(delta, zero, _CMP_GT_OQ)
+                              & _mm512_cmp_ps_mask(distance_hit, distance_min, _CMP_GT_OQ)
+                              & _mm512_cmp_ps_mask(distance_hit, distance_max, _CMP_LT_OQ);
+        if(valid != 0) {
+            return true;
+        }
+    }
+    return any_scalar(spheres, ray, index, last, distance);
+}
+
+#else
+
+auto sphere_kernel::closest_avx2(const sphere_array& spheres, const ray& ray, const int first, const int last, float& distance) -> int
+{
+    return closest_scalar(spheres, ray, first, last, distance);
+}
+
+bool sphere_kernel::any_avx2(const sphere_array& spheres, const ray& ray, const int first, const int last, const float distance)
+{
+    return any_scalar(spheres, ray, first, last, distance);
+}
+
+auto sphere_kernel::closest_avx512(const sphere_array& spheres, const ray& ray, const int first, const int last, float& distance) -> int
+{
+    return closest_scalar(spheres, ray, first, last, distance);
+}
+
+bool sphere_kernel::any_avx512(const sphere_array& spheres, const ray& ray, const int first, const int last, const float distance)
+{
+    return any_scalar(spheres, ray, first, last, distance);
+}
+
+#endif
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::plane_array
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+plane_array::plane_array()
+    : px()
+    , py()
+    , pz()
+    , nx()
+    , ny()
+    , nz()
+    , scale()
+    , material()
+{
+}
+
+void plane_array::clear()
+{
+    px.clear();
+    py.clear();
+    pz.clear();
+    nx.clear();
+    ny.clear();
+    nz.clear();
+    scale.clear();
+    material.clear();
+}
+
+void plane_array::add(const pos3f& plane_position, const vec3f& plane_normal, const float plane_scale, const int plane_material)
+{
+    px.push_back(plane_position.x);
+    py.push_back(plane_position.y);
+    pz.push_back(plane_position.z);
+    nx.push_back(plane_normal.x);
+    ny.push_back(plane_normal.y);
+    nz.push_back(plane_normal.z);
+    scale.push_back(plane_scale);
+    material.push_back(plane_material);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::glyph
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+glyph::glyph(const float glyph_radius)
+    : _radius(glyph_radius)
+    , _spheres()
+    , _bvh()
+    , _bounds()
+{
+    if(_radius <= 0.0f) {
+        throw std::runtime_error(std::string("rt::glyph is unable to create") + ',' + ' ' + "invalid radius");
+    }
+}
+
+void glyph::add(const pos3f& center)
+{
+    _spheres.add(center, _radius, 0);
+}
+
+void glyph::compile()
+{
+    const vec3f        extent((_radius * 1.001f), (_radius * 1.001f), (_radius * 1.001f));
+    const int          count = _spheres.size();
+    std::vector<box3f> boxes;
+
+    _bounds = box3f();
+    for(int index = 0; index < count; ++index) {
+        const box3f box((get_center(index) - extent), (get_center(index) + extent));
+        _bounds += box;
+        boxes.push_back(box);
+    }
+    _bvh.build(boxes, sphere_kernel::lanes());
+    _spheres.permute(_bvh.get_indices());
+}
+
+auto glyph::hit(const ray& ray, float& distance) const -> int
+{
+    const vec3f inverse ( (1.0f / ray.direction.x)
+                        , (1.0f / ray.direction.y)
+                        , (1.0f / ray.direction.z) );
+    int         primitive = -1;
+
+    auto hit_spheres = [&](const int first, const int count) -> void
+    {
+        const int index = sphere_kernel::closest(_spheres, ray, first, count, distance);
+        if(index >= 0) {
+            primitive = index;
+        }
+    };
+
+    _bvh.closest(ray, inverse, distance, hit_spheres);
+
+    return primitive;
+}
+
+bool glyph::occluded(const ray& ray, const float distance) const
+{
+    return occluder(ray, distance) >= 0;
+}
+
+auto glyph::visibility(const cone& cone) const -> float
+{
+    float visible = 1.0f;
+
+    auto enter_cone = [&](const box3f& bounds) -> bool
+    {
+        return cone.enter(bounds);
+    };
+
+    auto covered_spheres = [&](const int first, const int count) -> bool
+    {
+        const int last = first + count;
+        for(int index = first; index < last; ++index) {
+            visible *= (1.0f - cone.cover(get_center(index), _radius));
+            if(visible <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    if(_bvh.visit(enter_cone, covered_spheres)) {
+        return 0.0f;
+    }
+    return visible;
+}
+
+auto glyph::occluder(const ray& ray, const float distance) const -> int
+{
+    const vec3f inverse ( (1.0f / ray.direction.x)
+                        , (1.0f / ray.direction.y)
+                        , (1.0f / ray.direction.z) );
+    int occluder = -1;
+
+    auto occluded_spheres = [&](const int first, const int count) -> bool
+    {
+        if(sphere_kernel::any(_spheres, ray, first, count, distance) == false) {
+            return false;
+        }
+        const int last = first + count;
+        occluder = first;
+        for(int index = first; index < last; ++index) {
+            if(sphere_kernel::any(_spheres, ray, index, 1, distance)) {
+                occluder = index;
+                break;
+            }
+        }
+        return true;
+    };
+
+    static_cast<void>(_bvh.any(ray, inverse, distance, occluded_spheres));
+
+    return occluder;
+}
+
+bool glyph::occludes(const ray& ray, const float distance, const int primitive) const
+{
+    return sphere_kernel::any(_spheres, ray, primitive, 1, distance);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::instance
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+instance::instance ( const glyph& instance_glyph
+                   , const vec3f& instance_offset )
+    : object()
+    , _glyph(instance_glyph)
+    , _offset(instance_offset)
+{
+}
+
+/*
+ * instances are only translated, the direction and therefore the distances
+ * are the same in the world space and in the glyph space
+ */
+auto instance::to_local(const ray& ray) const -> rt::ray
+{
+    rt::ray local;
+
+    local.origin    = (ray.origin - _offset);
+    local.direction = ray.direction;
+
+    return local;
+}
+
+bool instance::hit(const ray& ray, hit_record& record) const
+{
+    float     distance  = record.distance;
+    const int primitive = _glyph.hit(to_local(ray), distance);
+
+    if(primitive >= 0) {
+        record.set(distance, hit_record::kind::object, this, primitive);
+        return true;
+    }
+    return false;
+}
+
+void instance::resolve(const ray& ray, const hit_record& record, const material& material, hit_result& result) const
+{
+    const pos3f center(_glyph.get_center(record.primitive) + _offset);
+    const vec3f oc(pos3f::difference(ray.origin, center));
+    const vec3f length(ray.direction * record.distance);
+    result.distance = record.distance;
+    result.position = pos3f(ray.origin + length);
+    result.normal   = vec3f(oc + length, true);
+    result.color    = material.color0;
+    result.reflect  = material.reflect;
+    result.refract  = material.refract;
+    result.eta      = material.eta;
+    result.specular = material.specular;
+}
+
+bool instance::occluded(const ray& ray, const float distance) const
+{
+    return _glyph.occluded(to_local(ray), distance);
+}
+
+auto instance::visibility(const cone& cone) const -> float
+{
+    rt::cone local(cone);
+
+    local.axis = to_local(cone.axis);
+
+    return _glyph.visibility(local);
+}
+
+auto instance::occluder(const ray& ray, const float distance) const -> int
+{
+    return _glyph.occluder(to_local(ray), distance);
+}
+
+bool instance::occludes(const ray& ray, const float distance, const int primitive) const
+{
+    return _glyph.occludes(to_local(ray), distance, primitive);
+}
+
+bool instance::bounds(box3f& box) const
+{
+    const box3f& local(_glyph.get_bounds());
+
+    box = box3f((local.min + _offset), (local.max + _offset));
+
+    return true;
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::light_tree
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+light_tree::light_tree()
+    : _nodes()
+    , _indices()
+    , _positions()
+    , _energies()
+{
+}
+
+/*
+ * the energy of a light is the numerator of its falloff, the brightness
+ * of a light decreasing with the square root of the distance
+ */
+void light_tree::build(const std::vector<light>& lights)
+{
+    const int count = static_cast<int>(lights.size());
+
+    clear();
+    if(count > 0) {
+        _nodes.reserve((2 * count) - 1);
+        for(int index = 0; index < count; ++index) {
+            const light& light(lights[index]);
+            const float  luminance = (light.color.r * 0.2126f) + (light.color.g * 0.7152f) + (light.color.b * 0.0722f);
+            _indices.push_back(index);
+            _positions.push_back(light.position);
+            _energies.push_back(std::max(luminance, 0.0f) * ::sqrtf(std::max(light.power, 0.0f)));
+        }
+        static_cast<void>(build(0, count));
+    }
+}
+
+void light_tree::clear()
+{
+    _nodes.clear();
+    _indices.clear();
+    _positions.clear();
+    _energies.clear();
+}
+
+/*
+ * the interior nodes hold the index of their right child, the left one
+ * being the next node, the leaves hold the index of their light
+ */
+auto light_tree::build(const int first, const int count) -> int
+{
+    const int current = static_cast<int>(_nodes.size());
+    node      parent{box3f(), 0.0f, 0, 0};
+
+    for(int index = first; index < (first + count); ++index) {
+        parent.bounds += _positions[_indices[index]];
+        parent.energy += _energies[_indices[index]];
+    }
+    _nodes.push_back(parent);
+    if(count == 1) {
+        _nodes[current].index = _indices[first];
+        _nodes[current].count = 1;
+        return current;
+    }
+    const vec3f extent(pos3f::difference(parent.bounds.max, parent.bounds.min));
+    const int   axis = ( (extent.x >= extent.y) && (extent.x >= extent.z) ? 0
+                       : (extent.y >= extent.z)                           ? 1
+                       :                                                    2 );
+    const int   half = count / 2;
+    std::nth_element ( (_indices.begin() + first)
+                     , (_indices.begin() + first + half)
+                     , (_indices.begin() + first + count)
+                     , [&](const int lhs, const int rhs) -> bool
+                       {
+                           const pos3f& l(_positions[lhs]);
+                           const pos3f& r(_positions[rhs]);
+                           return ( axis == 0 ? l.x < r.x
+                                  : axis == 1 ? l.y < r.y
+                                  :             l.z < r.z );
+                       } );
+    static_cast<void>(build(first, half));
+    _nodes[current].index = build((first + half), (count - half));
+    return current;
+}
+
+auto light_tree::importance(const box3f& bounds, const float energy, const pos3f& position) -> float
+{
+    const float radius   = vec3f::length(pos3f::difference(bounds.max, bounds.min)) * 0.5f;
+    const float distance = vec3f::length(pos3f::difference(bounds.center(), position));
+
+    return energy / ::sqrtf(std::max(std::max(distance, radius), static_cast<float>(DISTANCE_MIN)));
+}
+
+/*
+ * a light is picked in proportion to its estimated contribution at the
+ * given position, among all the lights when there are few of them, or by
+ * descending the tree otherwise, the random number being rescaled at each
+ * level and the probability of the choice being returned
+ */
+auto light_tree::sample(const pos3f& position, float random, float& probability) const -> int
+{
+    const int count = static_cast<int>(_positions.size());
+
+    auto sample_linear = [&]() -> int
+    {
+        float weights[LINEAR_MAX];
+        float total = 0.0f;
+        for(int index = 0; index < count; ++index) {
+            const box3f bounds(_positions[index], _positions[index]);
+            weights[index] = importance(bounds, _energies[index], position);
+            total += weights[index];
+        }
+        if(total <= 0.0f) {
+            const int index = std::min(static_cast<int>(random * count), (count - 1));
+            probability = 1.0f / static_cast<float>(count);
+            return index;
+        }
+        float target = random * total;
+        for(int index = 0; index < (count - 1); ++index) {
+            if(target < weights[index]) {
+                probability = weights[index] / total;
+                return index;
+            }
+            target -= weights[index];
+        }
+        probability = weights[count - 1] / total;
+        return (count - 1);
+    };
+
+    auto sample_tree = [&]() -> int
+    {
+        int current = 0;
+        probability = 1.0f;
+        while(_nodes[current].count == 0) {
+            const node& lhs(_nodes[current + 1]);
+            const node& rhs(_nodes[_nodes[current].index]);
+            const float lhs_weight = importance(lhs.bounds, lhs.energy, position);
+            const float rhs_weight = importance(rhs.bounds, rhs.energy, position);
+            const float total      = lhs_weight + rhs_weight;
+            const float threshold  = (total > 0.0f ? lhs_weight / total : 0.5f);
+            if((random < threshold) || (threshold >= 1.0f)) {
+                probability *= threshold;
+                random       = std::min(random / threshold, 1.0f - FLT_EPSILON);
+                current      = current + 1;
+            }
+            else {
+                probability *= (1.0f - threshold);
+                random       = std::min((random - threshold) / (1.0f - threshold), 1.0f - FLT_EPSILON);
+                current      = _nodes[current].index;
+            }
+        }
+        return _nodes[current].index;
+    };
+
+    auto execute = [&]() -> int
+    {
+        if(count <= LINEAR_MAX) {
+            return sample_linear();
+        }
+        return sample_tree();
+    };
+
+    return execute();
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::scene
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+scene::scene ( const camera& scene_camera
+             , const light&  scene_light
+             , const sky&    scene_sky )
+    : _camera(scene_camera)
+    , _lights(1, scene_light)
+    , _light_tree()
+    , _sky(scene_sky)
+    , _arena()
+    , _objects()
+    , _materials()
+    , _planes()
+    , _spheres()
+    , _spheres_bvh()
+    , _spheres_objects()
+    , _unbounded()
+    , _bounded()
+    , _bounded_bvh()
+{
+}
+
+auto scene::add_material(const material& material) -> int
+{
+    _materials.push_back(material);
+
+    return static_cast<int>(_materials.size() - 1);
+}
+
+/*
+ * the objects only hold an index, so that updating a material updates the
+ * whole group sharing it without rebuilding the scene
+ */
+void scene::set_material(const int index, const material& material)
+{
+    if((index < 0) || (index >= static_cast<int>(_materials.size()))) {
+        throw std::runtime_error(std::string("rt::scene is unable to set material") + ',' + ' ' + "invalid index");
+    }
+    _materials[index] = material;
+}
+
+/*
+ * moves a light and changes its power in place, the light tree picking
+ * them up at the next update
+ */
+void scene::set_light(const int index, const pos3f& position, const float power)
+{
+    if((index < 0) || (index >= static_cast<int>(_lights.size()))) {
+        throw std::runtime_error(std::string("rt::scene is unable to set light") + ',' + ' ' + "invalid index");
+    }
+    _lights[index].position = position;
+    _lights[index].power    = power;
+}
+
+/*
+ * planes and spheres are flattened into aligned SoA arrays referencing the
+ * material table, the remaining objects are kept behind their vtable
+ */
+void scene::compile(const int threads)
+{
+    std::vector<box3f>         spheres_boxes;
+    std::vector<box3f>         bounded_boxes;
+    std::vector<const object*> bounded;
+
+    auto get_material = [&](const object& object) -> int
+    {
+        const int material = object.get_material();
+        if((material < 0) || (material >= static_cast<int>(_materials.size()))) {
+            throw std::runtime_error(std::string("rt::scene is unable to compile") + ',' + ' ' + "invalid material");
+        }
+        return material;
+    };
+
+    auto add_object = [&](const object& object) -> void
+    {
+        if(auto plane_ptr = dynamic_cast<const plane*>(&object)) {
+            const int material = get_material(object);
+            _planes.add(plane_ptr->get_position(), plane_ptr->get_normal(), plane_ptr->get_scale(), material);
+            return;
+        }
+        if(auto sphere_ptr = dynamic_cast<const sphere*>(&object)) {
+            const int material = get_material(object);
+            box3f     box;
+            static_cast<void>(sphere_ptr->bounds(box));
+            _spheres.add(sphere_ptr->get_position(), sphere_ptr->get_radius(), material);
+            _spheres_objects.push_back(sphere_ptr);
+            spheres_boxes.push_back(box);
+            return;
+        }
+        static_cast<void>(get_material(object));
+        box3f box;
+        if(object.bounds(box) != false) {
+            bounded.push_back(&object);
+            bounded_boxes.push_back(box);
+        }
+        else {
+            _unbounded.push_back(&object);
+        }
+    };
+
+    auto clear = [&]() -> void
+    {
+        _planes.clear();
+        _spheres.clear();
+        _spheres_objects.clear();
+        _unbounded.clear();
+        _bounded.clear();
+    };
+
+    auto build = [&]() -> void
+    {
+        _spheres_bvh.build(spheres_boxes, sphere_kernel::lanes(), threads);
+        _spheres.permute(_spheres_bvh.get_indices());
+        std::vector<const sphere*> spheres_objects(_spheres_objects);
+        for(int slot = 0; slot < _spheres.size(); ++slot) {
+            _spheres_objects[slot] = spheres_objects[_spheres_bvh.get_indices()[slot]];
+        }
+        _bounded_bvh.build(bounded_boxes, 1, threads);
+        for(auto& index : _bounded_bvh.get_indices()) {
+            _bounded.push_back(bounded[index]);
+        }
+        _light_tree.build(_lights);
+    };
+
+    auto execute = [&]() -> void
+    {
+        clear();
+        for(auto& object : _objects) {
+            add_object(*object);
+        }
+        build();
+    };
+
+    return execute();
+}
+
+/*
+ * picks up the objects and lights moved in place since the last compile,
+ * the spheres being copied back into their slots, both hierarchies being
+ * refit and the light tree being rebuilt, the scene is compiled again when
+ * one of the hierarchies has degraded too much
+ */
+void scene::update(const int threads)
+{
+    std::vector<box3f> spheres_boxes(_spheres_objects.size());
+    std::vector<box3f> bounded_boxes(_bounded.size());
+
+    auto update_spheres = [&]() -> bool
+    {
+        const auto& indices(_spheres_bvh.get_indices());
+        const int   count = _spheres.size();
+        for(int slot = 0; slot < count; ++slot) {
+            const sphere& sphere(*_spheres_objects[slot]);
+            const pos3f&  position(sphere.get_position());
+            _spheres.x[slot]      = position.x;
+            _spheres.y[slot]      = position.y;
+            _spheres.z[slot]      = position.z;
+            _spheres.radius[slot] = sphere.get_radius();
+            static_cast<void>(sphere.bounds(spheres_boxes[indices[slot]]));
+        }
+        return _spheres_bvh.refit(spheres_boxes);
+    };
+
+    auto update_bounded = [&]() -> bool
+    {
+        const auto& indices(_bounded_bvh.get_indices());
+        const int   count = static_cast<int>(_bounded.size());
+        for(int slot = 0; slot < count; ++slot) {
+            static_cast<void>(_bounded[slot]->bounds(bounded_boxes[indices[slot]]));
+        }
+        return _bounded_bvh.refit(bounded_boxes);
+    };
+
+    auto update_lights = [&]() -> void
+    {
+        _light_tree.build(_lights);
+    };
+
+    auto execute = [&]() -> void
+    {
+        const bool spheres = update_spheres();
+        const bool bounded = update_bounded();
+        if((spheres == false) || (bounded == false)) {
+            compile(threads);
+        }
+        else {
+            update_lights();
+        }
+    };
+
+    return execute();
+}
+
+bool scene::hit(const ray& ray, hit_record& record) const
+{
+    const vec3f inverse ( (1.0f / ray.direction.x)
+                        , (1.0f / ray.direction.y)
+                        , (1.0f / ray.direction.z) );
+    bool        status = false;
+
+    auto hit_spheres = [&](const int first, const int count) -> void
+    {
+        float     distance = record.distance;
+        const int index    = sphere_kernel::closest(_spheres, ray, first, count, distance);
+        if(index >= 0) {
+            record.set(distance, hit_record::kind::sphere, nullptr, index);
+            status = true;
+        }
+    };
+
+    auto hit_objects = [&](const int first, const int count) -> void
+    {
+        const int last = first + count;
+        for(int index = first; index < last; ++index) {
+            status |= _bounded[index]->hit(ray, record);
+        }
+    };
+
+    auto execute = [&]() -> bool
+    {
+        status |= hit_planes(ray, record);
+        for(auto& object : _unbounded) {
+            status |= object->hit(ray, record);
+        }
+        _spheres_bvh.closest(ray, inverse, record.distance, hit_spheres);
+        _bounded_bvh.closest(ray, inverse, record.distance, hit_objects);
+        return status;
+    };
+
+    return execute();
+}
+
+/*
+ * the planes and the unbounded objects are hit lane by lane, the packet
+ * only goes down the hierarchies as a whole, the returned mask holds the
+ * lanes that did hit something
+ */
+auto scene::hit(const ray_packet& packet, hit_record* records) const -> uint32_t
+{
+    constexpr int LANES = ray_packet::LANES_MAX;
+    alignas(64) float distances[LANES];
+    const int         size   = packet.size();
+    uint32_t          status = 0;
+
+    auto for_each_lane = [&](const uint32_t mask, auto&& function) -> void
+    {
+        uint32_t bits = mask;
+        while(bits != 0) {
+            const int lane = __builtin_ctz(bits);
+            bits &= (bits - 1);
+            if(function(packet.rays[lane], records[lane])) {
+                status |= (UINT32_C(1) << lane);
+            }
+            distances[lane] = records[lane].distance;
+        }
+    };
+
+    auto hit_unbounded = [&](const rt::ray& ray, hit_record& record) -> bool
+    {
+        bool hit = hit_planes(ray, record);
+        for(auto& object : _unbounded) {
+            hit |= object->hit(ray, record);
+        }
+        return hit;
+    };
+
+    auto hit_spheres = [&](const int first, const int count, const uint32_t mask) -> void
+    {
+        for_each_lane(mask, [&](const rt::ray& ray, hit_record& record) -> bool
+        {
+            float     distance = record.distance;
+            const int index    = sphere_kernel::closest(_spheres, ray, first, count, distance);
+            if(index >= 0) {
+                record.set(distance, hit_record::kind::sphere, nullptr, index);
+                return true;
+            }
+            return false;
+        });
+    };
+
+    auto hit_objects = [&](const int first, const int count, const uint32_t mask) -> void
+    {
+        for_each_lane(mask, [&](const rt::ray& ray, hit_record& record) -> bool
+        {
+            const int last = first + count;
+            bool      hit  = false;
+            for(int index = first; index < last; ++index) {
+                hit |= _bounded[index]->hit(ray, record);
+            }
+            return hit;
+        });
+    };
+
+    auto execute = [&]() -> uint32_t
+    {
+        for(int lane = 0; lane < LANES; ++lane) {
+            distances[lane] = -1.0f;
+        }
+        for(int lane = 0; lane < size; ++lane) {
+            records[lane] = hit_record();
+        }
+        for_each_lane(packet.mask(), hit_unbounded);
+        _spheres_bvh.closest(packet, distances, hit_spheres);
+        _bounded_bvh.closest(packet, distances, hit_objects);
+        return status;
+    };
+
+    return execute();
+}
+
+/*
+ * computes position, normal, color and material of the winning primitive
+ */
+void scene::resolve(const ray& ray, const hit_record& record, hit_result& result) const
+{
+    auto resolve_plane = [&](const int index) -> void
+    {
+        const material& material(_materials[_planes.material[index]]);
+        const vec3f     normal(_planes.nx[index], _planes.ny[index], _planes.nz[index]);
+        const vec3f     length((ray.direction * record.distance));
+        result.distance = record.distance;
+        result.position = pos3f(ray.origin + length);
+        result.normal   = normal;
+        result.color    = plane::checker(result.position, _planes.scale[index], material.color1, material.color2);
+        result.reflect  = material.reflect;
+        result.refract  = material.refract;
+        result.eta      = material.eta;
+        result.specular = material.specular;
+    };
+
+    auto resolve_sphere = [&](const int index) -> void
+    {
+        const material& material(_materials[_spheres.material[index]]);
+        const vec3f     oc ( (ray.origin.x - _spheres.x[index])
+                           , (ray.origin.y - _spheres.y[index])
+                           , (ray.origin.z - _spheres.z[index]) );
+        const vec3f     length(ray.direction * record.distance);
+        result.distance = record.distance;
+        result.position = pos3f(ray.origin + length);
+        result.normal   = vec3f(oc + length, true);
+        result.color    = material.color0;
+        result.reflect  = material.reflect;
+        result.refract  = material.refract;
+        result.eta      = material.eta;
+        result.specular = material.specular;
+    };
+
+    switch(record.type) {
+        case hit_record::kind::plane:
+            resolve_plane(record.primitive);
+            break;
+        case hit_record::kind::sphere:
+            resolve_sphere(record.primitive);
+            break;
+        case hit_record::kind::object:
+            record.owner->resolve(ray, record, _materials[record.owner->get_material()], result);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * the full search records the primitive it stopped on, so that it can be
+ * tested first by the next shadow ray
+ */
+bool scene::occluded(const ray& ray, const float distance, hit_record& occluder) const
+{
+    const vec3f inverse ( (1.0f / ray.direction.x)
+                        , (1.0f / ray.direction.y)
+                        , (1.0f / ray.direction.z) );
+
+    auto occluded_planes = [&]() -> bool
+    {
+        const int count = _planes.size();
+        for(int index = 0; index < count; ++index) {
+            if(plane_occludes(index, ray, distance)) {
+                occluder.set(0.0f, hit_record::kind::plane, nullptr, index);
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto occluded_object = [&](const object* object) -> bool
+    {
+        const int primitive = object->occluder(ray, distance);
+        if(primitive >= 0) {
+            occluder.set(0.0f, hit_record::kind::object, object, primitive);
+            return true;
+        }
+        return false;
+    };
+
+    auto occluded_spheres = [&](const int first, const int count) -> bool
+    {
+        if(sphere_kernel::any(_spheres, ray, first, count, distance) == false) {
+            return false;
+        }
+        const int last = first + count;
+        for(int index = first; index < last; ++index) {
+            if(sphere_kernel::any(_spheres, ray, index, 1, distance)) {
+                occluder.set(0.0f, hit_record::kind::sphere, nullptr, index);
+                break;
+            }
+        }
+        return true;
+    };
+
+    auto occluded_objects = [&](const int first, const int count) -> bool
+    {
+        const int last = first + count;
+        for(int index = first; index < last; ++index) {
+            if(occluded_object(_bounded[index])) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto execute = [&]() -> bool
+    {
+        if(occluded_planes()) {
+            return true;
+        }
+        for(auto& object : _unbounded) {
+            if(occluded_object(object)) {
+                return true;
+            }
+        }
+        if(_spheres_bvh.any(ray, inverse, distance, occluded_spheres)) {
+            return true;
+        }
+        if(_bounded_bvh.any(ray, inverse, distance, occluded_objects)) {
+            return true;
+        }
+        return false;
+    };
+
+    return execute();
+}
+
+/*
+ * the neighbouring shadow rays are mostly blocked by the same primitive,
+ * which is tested alone before any full search
+ */
+bool scene::occludes(const ray& ray, const float distance, const hit_record& occluder) const
+{
+    auto execute = [&]() -> bool
+    {
+        switch(occluder.type) {
+            case hit_record::kind::plane:
+                return plane_occludes(occluder.primitive, ray, distance);
+            case hit_record::kind::sphere:
+                return sphere_kernel::any(_spheres, ray, occluder.primitive, 1, distance);
+            case hit_record::kind::object:
+                return occluder.owner->occludes(ray, distance, occluder.primitive);
+            default:
+                break;
+        }
+        return false;
+    };
+
+    return execute();
+}
+
+/*
+ * the spheres hide a part of the light, the overlaps being taken as
+ * independent, while the planes only block the axis of the cone
+ */
+auto scene::visibility(const cone& cone) const -> float
+{
+    const ray&  ray(cone.axis);
+    const float distance = cone.distance;
+    float       visible  = 1.0f;
+
+    if(cone.angle <= 0.0f) {
+        hit_record occluder;
+        return (occluded(ray, distance, occluder) ? 0.0f : 1.0f);
+    }
+
+    auto enter_cone = [&](const box3f& bounds) -> bool
+    {
+        return cone.enter(bounds);
+    };
+
+    auto occluded_planes = [&]() -> bool
+    {
+        const int count = _planes.size();
+        for(int index = 0; index < count; ++index) {
+            if(plane_occludes(index, ray, distance)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto covered_spheres = [&](const int first, const int count) -> bool
+    {
+        const int last = first + count;
+        for(int index = first; index < last; ++index) {
+            const pos3f center(_spheres.x[index], _spheres.y[index], _spheres.z[index]);
+            visible *= (1.0f - cone.cover(center, _spheres.radius[index]));
+            if(visible <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto covered_objects = [&](const int first, const int count) -> bool
+    {
+        const int last = first + count;
+        for(int index = first; index < last; ++index) {
+            visible *= _bounded[index]->visibility(cone);
+            if(visible <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto execute = [&]() -> float
+    {
+        if(occluded_planes()) {
+            return 0.0f;
+        }
+        for(auto& object : _unbounded) {
+            visible *= object->visibility(cone);
+            if(visible <= 0.0f) {
+                return 0.0f;
+            }
+        }
+        if(_spheres_bvh.visit(enter_cone, covered_spheres)) {
+            return 0.0f;
+        }
+        if(_bounded_bvh.visit(enter_cone, covered_objects)) {
+            return 0.0f;
+        }
+        return visible;
+    };
+
+    return execute();
+}
+
+bool scene::hit_planes(const ray& ray, hit_record& record) const
+{
+    const int count  = _planes.size();
+    bool      status = false;
+    for(int index = 0; index < count; ++index) {
+        const vec3f normal(_planes.nx[index], _planes.ny[index], _planes.nz[index]);
+        const vec3f oc ( (ray.origin.x - _planes.px[index])
+                       , (ray.origin.y - _planes.py[index])
+                       , (ray.origin.z - _planes.pz[index]) );
+        constexpr float distance_min = hit_result::DISTANCE_MIN;
+        const     float distance_max = record.distance;
+        const     float distance_hit = -vec3f::dot(oc, normal) / vec3f::dot(ray.direction, normal);
+        if((distance_hit > distance_min) && (distance_hit < distance_max)) {
+            record.set(distance_hit, hit_record::kind::plane, nullptr, index);
+            status = true;
+        }
+    }
+    return status;
+}
+
+bool scene::plane_occludes(const int index, const ray& ray, const float distance) const
+{
+    const vec3f normal(_planes.nx[index], _planes.ny[index], _planes.nz[index]);
+    const vec3f oc ( (ray.origin.x - _planes.px[index])
+                   , (ray.origin.y - _planes.py[index])
+                   , (ray.origin.z - _planes.pz[index]) );
+    constexpr float distance_min = hit_result::DISTANCE_MIN;
+    const     float distance_max = distance;
+    const     float distance_hit = -vec3f::dot(oc, normal) / vec3f::dot(ray.direction, normal);
+
+    return (distance_hit > distance_min) && (distance_hit < distance_max);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::ray_queue
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+ray_queue::ray_queue()
+    : ox()
+    , oy()
+    , oz()
+    , dx()
+    , dy()
+    , dz()
+    , wr()
+    , wg()
+    , wb()
+    , distance()
+    , pixel()
+    , stream()
+    , dimension()
+    , _keys()
+    , _order()
+    , _floats()
+{
+}
+
+void ray_queue::clear()
+{
+    ox.clear();
+    oy.clear();
+    oz.clear();
+    dx.clear();
+    dy.clear();
+    dz.clear();
+    wr.clear();
+    wg.clear();
+    wb.clear();
+    distance.clear();
+    pixel.clear();
+    stream.clear();
+    dimension.clear();
+}
+
+void ray_queue::add(const ray& ray, const col3f& ray_weight, const float ray_distance, const int ray_pixel, const uint32_t ray_stream, const uint32_t ray_dimension)
+{
+    ox.push_back(ray.origin.x);
+    oy.push_back(ray.origin.y);
+    oz.push_back(ray.origin.z);
+    dx.push_back(ray.direction.x);
+    dy.push_back(ray.direction.y);
+    dz.push_back(ray.direction.z);
+    wr.push_back(ray_weight.r);
+    wg.push_back(ray_weight.g);
+    wb.push_back(ray_weight.b);
+    distance.push_back(ray_distance);
+    pixel.push_back(ray_pixel);
+    stream.push_back(static_cast<int32_t>(ray_stream));
+    dimension.push_back(static_cast<int32_t>(ray_dimension));
+}
+
+/*
+ * the rays are counting-sorted by the Morton code of their quantized
+ * direction so that consecutive rays of a stage are coherent and can
+ * travel as packets
+ */
+void ray_queue::sort()
+{
+    constexpr int BITS    = 3;
+    constexpr int BUCKETS = (1 << (BITS * 3));
+    const int     count   = size();
+
+    auto quantize = [](const float value) -> int
+    {
+        constexpr int max = ((1 << BITS) - 1);
+
+        return std::max(0, std::min(max, static_cast<int>((value + 1.0f) * (0.5f * (max + 1)))));
+    };
+
+    auto spread = [](const int value) -> int
+    {
+        return ((value & 1) << 0) | ((value & 2) << 2) | ((value & 4) << 4);
+    };
+
+    auto gather = [&](auto& values, auto& scratch) -> void
+    {
+        scratch.resize(count);
+        for(int index = 0; index < count; ++index) {
+            scratch[index] = values[_order[index]];
+        }
+        values.swap(scratch);
+    };
+
+    auto order = [&]() -> void
+    {
+        int offsets[BUCKETS + 1] = {};
+        _keys.resize(count);
+        _order.resize(count);
+        for(int index = 0; index < count; ++index) {
+            const int key = (spread(quantize(dx[index])) << 0)
+                          | (spread(quantize(dy[index])) << 1)
+                          | (spread(quantize(dz[index])) << 2);
+            _keys[index] = key;
+            ++offsets[key + 1];
+        }
+        for(int bucket = 0; bucket < BUCKETS; ++bucket) {
+            offsets[bucket + 1] += offsets[bucket];
+        }
+        for(int index = 0; index < count; ++index) {
+            _order[offsets[_keys[index]]++] = index;
+        }
+    };
+
+    auto execute = [&]() -> void
+    {
+        order();
+        gather(ox, _floats);
+        gather(oy, _floats);
+        gather(oz, _floats);
+        gather(dx, _floats);
+        gather(dy, _floats);
+        gather(dz, _floats);
+        gather(wr, _floats);
+        gather(wg, _floats);
+        gather(wb, _floats);
+        gather(distance, _floats);
+        gather(pixel, _keys);
+        gather(stream, _keys);
+        gather(dimension, _keys);
+    };
+
+    return execute();
+}
+
+void ray_queue::swap(ray_queue& other)
+{
+    ox.swap(other.ox);
+    oy.swap(other.oy);
+    oz.swap(other.oz);
+    dx.swap(other.dx);
+    dy.swap(other.dy);
+    dz.swap(other.dz);
+    wr.swap(other.wr);
+    wg.swap(other.wg);
+    wb.swap(other.wb);
+    distance.swap(other.distance);
+    pixel.swap(other.pixel);
+    stream.swap(other.stream);
+    dimension.swap(other.dimension);
+}
+
+/*
+ * the directions are stored normalized, the ray is rebuilt as is
+ */
+auto ray_queue::get_ray(const int index) const -> ray
+{
+    rt::ray ray;
+    ray.origin    = pos3f(ox[index], oy[index], oz[index]);
+    ray.direction = vec3f(dx[index], dy[index], dz[index]);
+    return ray;
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::raytracer
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+raytracer::raytracer(const scene& scene, const int recursions, const base::sampler& sampler)
+    : _scene(scene)
+    , _sampler(sampler)
+    , _cutoff(0.0f)
+    , _roulette(0)
+    , _stochastic(false)
+    , _light_samples(1)
+    , _analytic_shadows(false)
+    , _occluder()
+    , _statistics()
+    , _stack(std::max(recursions, 0) + 1)
+{
+}
+
+bool raytracer::hit(const ray& ray, hit_record& record)
+{
+    return _scene.hit(ray, record);
+}
+
+bool raytracer::occluded(const ray& ray, const float distance)
+{
+    ++_statistics.shadow_rays;
+    if(_scene.occludes(ray, distance, _occluder)) {
+        ++_statistics.occluded;
+        ++_statistics.cache_hits;
+        return true;
+    }
+    if(_scene.occluded(ray, distance, _occluder)) {
+        ++_statistics.occluded;
+        return true;
+    }
+    return false;
+}
+
+auto raytracer::visibility(const ray& ray, const float distance, const float radius) -> float
+{
+    return _scene.visibility(cone(ray, distance, radius));
+}
+
+/*
+ * every light is sampled when there are no more lights than shadow rays,
+ * otherwise the shadow rays go to lights picked by importance, weighted
+ * by the inverse of their probability
+ */
+auto raytracer::select(const pos3f& position, int* lights, float* scales) -> int
+{
+    const int count   = static_cast<int>(_scene.get_lights().size());
+    const int samples = std::max(1, std::min(_light_samples, static_cast<int>(LIGHTS_MAX)));
+
+    if(count <= samples) {
+        for(int index = 0; index < count; ++index) {
+            lights[index] = index;
+            scales[index] = 1.0f;
+        }
+        return count;
+    }
+    for(int index = 0; index < samples; ++index) {
+        float probability = 1.0f;
+        lights[index] = _scene.get_light_tree().sample(position, _sampler(), probability);
+        scales[index] = 1.0f / (probability * static_cast<float>(samples));
+    }
+    return samples;
+}
+
+col3f raytracer::trace(const rt::ray& ray, const int recursion)
+{
+    return integrate(ray, recursion, nullptr);
+}
+
+/*
+ * only the primary rays are traced as a packet, the lanes being shaded in
+ * order as single rays since the secondary rays do not stay coherent, the
+ * lanes holding the consecutive samples of the current one
+ */
+void raytracer::trace(const rt::ray_packet& packet, const int recursion, col3f* colors)
+{
+    const rt::sky& sky    = _scene.get_sky();
+    const int      size   = packet.size();
+    const uint32_t stream = _sampler.get_stream();
+    const uint32_t sample = _sampler.get_sample();
+
+    if(recursion <= 0) {
+        for(int lane = 0; lane < size; ++lane) {
+            colors[lane] = sky.ambient;
+        }
+        return;
+    }
+
+    rt::hit_record records[rt::ray_packet::LANES_MAX];
+    const uint32_t mask = _scene.hit(packet, records);
+    for(int lane = 0; lane < size; ++lane) {
+        const rt::ray& ray(packet.rays[lane]);
+        _sampler.set(stream, (sample + lane), CAMERA_DIMENSIONS);
+        if((mask & (UINT32_C(1) << lane)) == 0) {
+            colors[lane] = sky.color * ::powf(1.0f - ray.direction.z, 4.0f);
+        }
+        else {
+            colors[lane] = integrate(ray, recursion, &records[lane]);
+        }
+    }
+}
+
+/*
+ * Russian roulette on the weight of the path a secondary ray would carry,
+ * always below the cutoff and from the given bounce on, the factor of the
+ * surviving rays being scaled up so that the estimate stays unbiased, the
+ * roll being drawn from the first dimension of the block of that ray
+ */
+bool raytracer::survive(const float weight, float& factor, const int bounce, const uint32_t dimension)
+{
+    const float path = weight * factor;
+    float probability = 1.0f;
+
+    if((_roulette > 0) && (bounce >= _roulette)) {
+        probability = std::min(probability, path);
+    }
+    if(path < _cutoff) {
+        probability = std::min(probability, path / _cutoff);
+    }
+    if(probability >= 1.0f) {
+        return true;
+    }
+    if(_sampler.get(dimension) >= probability) {
+        return false;
+    }
+    factor /= probability;
+    return true;
+}
+
+/*
+ * only one of the reflected and refracted rays is traced, chosen in
+ * proportion to its factor and carrying the sum of both
+ */
+void raytracer::branch(float& reflect_factor, float& refract_factor)
+{
+    if((_stochastic == false) || (reflect_factor <= 0.0f) || (refract_factor <= 0.0f)) {
+        return;
+    }
+    const float total = reflect_factor + refract_factor;
+    if((_sampler() * total) < reflect_factor) {
+        reflect_factor = total;
+        refract_factor = 0.0f;
+    }
+    else {
+        reflect_factor = 0.0f;
+        refract_factor = total;
+    }
+}
+
+/*
+ * every ray of a path tree owns a block of dimensions, the first one
+ * being kept for its Russian roulette and the others for its shading
+ *
+ * the blocks are numbered as a binary heap so that the children of a ray
+ * never share the dimensions of another ray, the rays deeper than the
+ * heap can number getting a hashed block past the heap so that the
+ * dimensions never wrap
+ */
+auto raytracer::child_dimension(const uint32_t parent, const uint32_t child) -> uint32_t
+{
+    const uint32_t node  = (parent - CAMERA_DIMENSIONS) / BOUNCE_DIMENSIONS;
+    uint32_t       block = (2 * node) + child;
+
+    if(block >= HEAP_BLOCKS) {
+        block = HEAP_BLOCKS + (base::randomizer::mix(block) % HEAP_BLOCKS);
+    }
+    return CAMERA_DIMENSIONS + (block * BOUNCE_DIMENSIONS);
+}
+
+/*
+ * the paths are followed depth first with an explicit stack of pending
+ * rays, each of them holding the weight of its path and the first of its
+ * dimensions, the record of the primary ray being given when it has
+ * already been traced
+ *
+ * every level pushes at most one more ray than it pops, so the stack
+ * never holds more than one ray per level
+ */
+col3f raytracer::integrate(const rt::ray& ray, const int recursion, const hit_record* record)
+{
+    const rt::sky& sky      = _scene.get_sky();
+    const uint32_t stream   = _sampler.get_stream();
+    const uint32_t sample   = _sampler.get_sample();
+    rt::col3f      color;
+    int            top      = 0;
+    const bool     roulette = (_cutoff > 0.0f) || (_roulette > 0);
+
+    if(static_cast<int>(_stack.size()) <= recursion) {
+        _stack.resize(recursion + 1);
+    }
+    pending* const stack = _stack.data();
+    stack[top++] = pending{ray, 1.0f, 1.0f, recursion, 0, CAMERA_DIMENSIONS};
+    while(top > 0) {
+        pending entry(stack[--top]);
+        _sampler.set(stream, sample, (entry.dimension + 1));
+        if(roulette && (entry.bounce > 0) && (survive(entry.weight, entry.factor, entry.bounce, entry.dimension) == false)) {
+            continue;
+        }
+        entry.weight *= entry.factor;
+        if(entry.depth <= 0) {
+            color += (sky.ambient * entry.weight);
+            continue;
+        }
+        rt::hit_record hit_record;
+        if(record != nullptr) {
+            hit_record = *record;
+            record     = nullptr;
+        }
+        else if(hit(entry.path, hit_record) == false) {
+            color += ((sky.color * ::powf(1.0f - entry.path.direction.z, 4.0f)) * entry.weight);
+            continue;
+        }
+        rt::hit_result result;
+        _scene.resolve(entry.path, hit_record, result);
+        top += shade(entry, result, &stack[top], color);
+    }
+    return color;
+}
+
+/*
+ * the local terms are accumulated with the weight of the path, the
+ * refracted then reflected rays being pushed as children so that the
+ * reflected one is followed first, the rays of the last level only
+ * bringing the ambient light without being pushed
+ */
+auto raytracer::shade(const pending& entry, const rt::hit_result& result, pending* children, col3f& color) -> int
+{
+    const std::vector<rt::light>& lights(_scene.get_lights());
+    const rt::sky& sky    = _scene.get_sky();
+    const rt::ray& ray(entry.path);
+    const float    weight = entry.weight;
+    const int      depth  = entry.depth - 1;
+    const int      bounce = entry.bounce + 1;
+
+    const rt::ray reflected_ray(ray.reflect(result.distance, result.normal));
+
+    rt::col3f   local_color;
+    const float specular_factor = result.specular;
+    const float refract_factor  = result.refract;
+    const float reflect_factor  = result.reflect;
+    const float surface_factor  = (1.0f - (reflect_factor + refract_factor));
+    const float ambient_factor  = (1.0f - (reflect_factor + refract_factor)) * 1.0f;
+    float       reflect_weight  = reflect_factor;
+    float       refract_weight  = refract_factor;
+    int         count           = 0;
+
+    auto ambient_color = [&]() -> void
+    {
+        if(ambient_factor > 0.0f) {
+            local_color += ((result.color * sky.ambient) * ambient_factor);
+        }
+    };
+
+    auto light_color = [&](const rt::light& light, const float scale) -> void
+    {
+        const pos3f light_pos ( _analytic_shadows ? light.position
+                              : pos3f ( (light.position.x + random2())
+                                      , (light.position.y + random2())
+                                      , (light.position.z + random2()) ) );
+
+        const vec3f light_vec(pos3f::difference(light_pos, result.position));
+
+        const rt::ray light_ray(result.position, light_vec);
+
+        const float light_distance(vec3f::length(pos3f::difference(light.position, result.position)));
+
+        float diffusion = vec3f::dot(light_ray.direction, result.normal);
+
+        float visible = 1.0f;
+
+        if(diffusion <= 0.0f) {
+            return;
+        }
+
+        /* cast_shadows */ {
+            if(_analytic_shadows) {
+                visible = visibility(light_ray, light_distance, light.radius);
+                if(visible <= 0.0f) {
+                    return;
+                }
+            }
+            else if(occluded(light_ray, vec3f::length(light_vec)) != false) {
+                return;
+            }
+        }
+
+        const rt::col3f light_color(light.color * ((1.0f / ::sqrtf(light_distance / light.power)) * (scale * visible)));
+        const float     diffuse_factor = surface_factor * diffusion;
+
+        if(diffuse_factor > 0.0f) {
+            local_color += ((result.color * light_color) * diffuse_factor);
+        }
+        if(specular_factor > 0.0f) {
+            const float phong = ::powf(vec3f::dot(light_ray.direction, reflected_ray.direction), specular_factor);
+            local_color += (light_color * phong);
+        }
+    };
+
+    auto direct_color = [&]() -> void
+    {
+        int   selected[LIGHTS_MAX];
+        float scales[LIGHTS_MAX];
+        const int samples = select(result.position, selected, scales);
+        for(int index = 0; index < samples; ++index) {
+            light_color(lights[selected[index]], scales[index]);
+        }
+    };
+
+    auto last_child = [&](float factor, const uint32_t child) -> void
+    {
+        if((factor > 0.0f) && survive(weight, factor, bounce, child_dimension(entry.dimension, child))) {
+            color += (sky.ambient * (weight * factor));
+        }
+    };
 
-namespace rt {
+    auto reflect_child = [&]() -> void
+    {
+        if(reflect_weight > 0.0f) {
+            children[count++] = pending{reflected_ray, weight, reflect_weight, depth, bounce, child_dimension(entry.dimension, 1)};
+        }
+    };
 
-cylinder::cylinder ( const pos3f& cylinder_point1
-                   , const pos3f& cylinder_point2
-                   , const float  cylinder_radius )
-    : object()
-    , _point1(cylinder_point1)
-    , _point2(cylinder_point2)
-    , _radius(cylinder_radius)
-{
-}
+    auto refract_child = [&]() -> void
+    {
+        if(refract_weight > 0.0f) {
+            const rt::ray refracted_ray(ray.refract(result.distance, result.normal, result.eta));
+            children[count++] = pending{refracted_ray, weight, refract_weight, depth, bounce, child_dimension(entry.dimension, 2)};
+        }
+    };
 
-bool cylinder::hit(const ray& ray, hit_result& result) const
-{
-    return false;
+    ambient_color();
+    direct_color();
+    color += (local_color * weight);
+    branch(reflect_weight, refract_weight);
+    if(depth <= 0) {
+        last_child(reflect_weight, 1);
+        last_child(refract_weight, 2);
+        return count;
+    }
+    refract_child();
+    reflect_child();
+    return count;
 }
 
 }
 
 // ---------------------------------------------------------------------------
-// rt::scene
+// rt::wavefront
 // ---------------------------------------------------------------------------
 
 namespace rt {
 
-scene::scene ( const camera& scene_camera
-             , const light&  scene_light
-             , const sky&    scene_sky )
-    : _camera(scene_camera)
-    , _light(scene_light)
-    , _sky(scene_sky)
-    , _objects()
+wavefront::wavefront(const scene& scene, const base::sampler& sampler)
+    : raytracer(scene, 0, sampler)
+    , _records()
+    , _shadows()
+    , _secondary()
 {
 }
 
-}
+/*
+ * breadth-first integrator, the rays of a bounce are intersected in bulk,
+ * then shaded into a shadow queue carrying the diffuse and specular terms
+ * and a secondary queue carrying the reflected and refracted rays, both
+ * being sorted before being processed in bulk as well
+ */
+void wavefront::trace(ray_queue& rays, const int recursion, const int packets, col3f* pixels)
+{
+    const rt::sky& sky = _scene.get_sky();
 
-// ---------------------------------------------------------------------------
-// rt::raytracer
-// ---------------------------------------------------------------------------
+    auto terminate = [&]() -> void
+    {
+        const int count = rays.size();
+        for(int index = 0; index < count; ++index) {
+            pixels[rays.pixel[index]] += (rays.get_weight(index) * sky.ambient);
+        }
+        rays.clear();
+    };
 
-namespace rt {
+    auto execute = [&]() -> void
+    {
+        for(int depth = recursion; rays.size() > 0; --depth) {
+            if(depth <= 0) {
+                return terminate();
+            }
+            _shadows.clear();
+            _secondary.clear();
+            extend(rays, packets);
+            shade(rays, pixels, (recursion - depth));
+            _shadows.sort();
+            shadow(_shadows, pixels);
+            _secondary.sort();
+            rays.swap(_secondary);
+        }
+    };
 
-raytracer::raytracer(const scene& scene)
-    : _scene(scene)
-    , _random1(-0.50f, +0.50f)
-    , _random2(-0.75f, +0.75f)
-{
+    return execute();
 }
 
-bool raytracer::hit(const ray& ray, hit_result& result)
+void wavefront::extend(const ray_queue& rays, const int packets)
 {
-    bool status = false;
-
-    const auto& objects = _scene.get_objects();
-    for(auto& object : objects) {
-        status |= object->hit(ray, result);
+    const int  count = rays.size();
+    const int  step  = std::max(1, std::min(packets, static_cast<int>(ray_packet::LANES_MAX)));
+    ray_packet packet;
+
+    _records.resize(count);
+    for(int first = 0; first < count; first += step) {
+        const int size = std::min(step, count - first);
+        if(size > 1) {
+            for(int lane = 0; lane < size; ++lane) {
+                packet.add(rays.get_ray(first + lane));
+            }
+            static_cast<void>(_scene.hit(packet, &_records[first]));
+            packet.clear();
+        }
+        else {
+            _records[first] = hit_record();
+            static_cast<void>(hit(rays.get_ray(first), _records[first]));
+        }
     }
-
-    return status;
 }
 
-col3f raytracer::trace(const rt::ray& ray, const int recursion)
+/*
+ * every ray carries the random stream of its pixel and the first of its
+ * dimensions, the current sample being the one of the whole wave
+ */
+void wavefront::shade(const ray_queue& rays, col3f* pixels, const int bounce)
 {
-    const rt::light& light = _scene.get_light();
-    const rt::sky&   sky   = _scene.get_sky();
+    const std::vector<rt::light>& lights(_scene.get_lights());
+    const rt::sky&   sky    = _scene.get_sky();
+    const int        count  = rays.size();
+    const uint32_t   sample = _sampler.get_sample();
+
+    for(int index = 0; index < count; ++index) {
+        const rt::ray         ray(rays.get_ray(index));
+        const rt::col3f       weight(rays.get_weight(index));
+        const int             pixel(rays.pixel[index]);
+        const uint32_t        stream(rays.stream[index]);
+        const uint32_t        dimension(rays.dimension[index]);
+        const rt::hit_record& record(_records[index]);
+        if(record.empty()) {
+            pixels[pixel] += (weight * (sky.color * ::powf(1.0f - ray.direction.z, 4.0f)));
+            continue;
+        }
+        rt::hit_result result;
+        _scene.resolve(ray, record, result);
+        _sampler.set(stream, sample, (dimension + 1));
 
-    if(recursion <= 0) {
-        return sky.ambient;
-    }
+        const float     specular_factor = result.specular;
+        const float     refract_factor  = result.refract;
+        const float     reflect_factor  = result.reflect;
+        const float     surface_factor  = (1.0f - (reflect_factor + refract_factor));
+        const float     ambient_factor  = (1.0f - (reflect_factor + refract_factor)) * 1.0f;
+        const float     path_weight     = std::max(weight.r, std::max(weight.g, weight.b));
+        float           reflect_weight  = reflect_factor;
+        float           refract_weight  = refract_factor;
 
-    rt::hit_result result;
-    if(hit(ray, result) == false) {
-        return sky.color * ::powf(1.0f - ray.direction.z, 4.0f);
-    }
+        const rt::ray   reflected_ray(ray.reflect(result.distance, result.normal));
+        int             selected[LIGHTS_MAX];
+        float           scales[LIGHTS_MAX];
+        const int       samples = select(result.position, selected, scales);
 
-    const pos3f light_pos ( (light.position.x + _random2())
-                          , (light.position.y + _random2())
-                          , (light.position.z + _random2()) );
+        /* the diffuse and specular terms only depend on the shadow rays */
+        for(int light_index = 0; light_index < samples; ++light_index) {
+            const rt::light& light(lights[selected[light_index]]);
 
-    const rt::ray light_ray(result.position, pos3f::difference(light_pos, result.position));
+            const pos3f light_pos ( _analytic_shadows ? light.position
+                                  : pos3f ( (light.position.x + random2())
+                                          , (light.position.y + random2())
+                                          , (light.position.z + random2()) ) );
 
-    const rt::ray reflected_ray(ray.reflect(result.distance, result.normal));
+            const vec3f light_vec(pos3f::difference(light_pos, result.position));
 
-    const rt::ray refracted_ray(ray.refract(result.distance, result.normal, result.eta));
+            const rt::ray light_ray(result.position, light_vec);
 
-    const float light_distance(vec3f::length(pos3f::difference(light.position, result.position)));
+            const float light_distance(vec3f::length(pos3f::difference(light.position, result.position)));
 
-    float diffusion = vec3f::dot(light_ray.direction, result.normal);
+            const float diffusion = std::max(vec3f::dot(light_ray.direction, result.normal), 0.0f);
 
-    if(diffusion < 0.0f) {
-        diffusion = 0.0f;
-    }
+            const rt::col3f light_color(light.color * ((1.0f / ::sqrtf(light_distance / light.power)) * scales[light_index]));
+            const float     diffuse_factor = surface_factor * diffusion;
+            rt::col3f       lit_color;
 
-    /* cast_shadows */ {
-        rt::hit_result dummy;
-        if(hit(light_ray, dummy) != false) {
-            diffusion = 0.0f;
+            if(diffuse_factor > 0.0f) {
+                lit_color += ((result.color * light_color) * diffuse_factor);
+            }
+            if((specular_factor > 0.0f) && (diffusion > 0.0f)) {
+                lit_color += (light_color * ::powf(vec3f::dot(light_ray.direction, reflected_ray.direction), specular_factor));
+            }
+            if((diffusion > 0.0f) && _analytic_shadows) {
+                pixels[pixel] += (weight * (lit_color * visibility(light_ray, light_distance, light.radius)));
+            }
+            else if(diffusion > 0.0f) {
+                _shadows.add(light_ray, (weight * lit_color), vec3f::length(light_vec), pixel, stream, dimension);
+            }
         }
-    }
-
-    rt::col3f   final_color;
-    rt::col3f   light_color(light.color * (1.0f / ::sqrtf(light_distance / light.power)));
-    const float specular_factor = result.specular;
-    const float refract_factor  = result.refract;
-    const float reflect_factor  = result.reflect;
-    const float diffuse_factor  = (1.0f - (reflect_factor + refract_factor)) * diffusion;
-    const float ambient_factor  = (1.0f - (reflect_factor + refract_factor)) * 1.0f;
-
-    auto ambient_color = [&]() -> void
-    {
         if(ambient_factor > 0.0f) {
-            final_color += ((result.color * sky.ambient) * ambient_factor);
+            pixels[pixel] += (weight * ((result.color * sky.ambient) * ambient_factor));
         }
-    };
-
-    auto diffuse_color = [&]() -> void
-    {
-        if(diffuse_factor > 0.0f) {
-            final_color += ((result.color * light_color) * diffuse_factor);
+        branch(reflect_weight, refract_weight);
+        if((reflect_weight > 0.0f) && survive(path_weight, reflect_weight, (bounce + 1), child_dimension(dimension, 1))) {
+            _secondary.add(reflected_ray, (weight * reflect_weight), hit_result::DISTANCE_MAX, pixel, stream, child_dimension(dimension, 1));
         }
-    };
-
-    auto reflect_color = [&]() -> void
-    {
-        if(reflect_factor > 0.0f) {
-            final_color += (trace(reflected_ray, (recursion - 1)) * reflect_factor);
+        if((refract_weight > 0.0f) && survive(path_weight, refract_weight, (bounce + 1), child_dimension(dimension, 2))) {
+            const rt::ray refracted_ray(ray.refract(result.distance, result.normal, result.eta));
+            _secondary.add(refracted_ray, (weight * refract_weight), hit_result::DISTANCE_MAX, pixel, stream, child_dimension(dimension, 2));
         }
-    };
+    }
+}
 
-    auto refract_color = [&]() -> void
-    {
-        if(refract_factor > 0.0f) {
-            final_color += (trace(refracted_ray, (recursion - 1)) * refract_factor);
-        }
-    };
+void wavefront::shadow(const ray_queue& shadows, col3f* pixels)
+{
+    const int count = shadows.size();
 
-    auto specular_color = [&]() -> void
-    {
-        if(specular_factor > 0.0f) {
-            const float phong = ::powf(vec3f::dot(light_ray.direction, reflected_ray.direction) * (diffusion > 0.0f), specular_factor);
-            final_color += (light_color * phong);
+    for(int index = 0; index < count; ++index) {
+        if(occluded(shadows.get_ray(index), shadows.distance[index]) == false) {
+            pixels[shadows.pixel[index]] += shadows.get_weight(index);
         }
-    };
-
-    ambient_color();
-    diffuse_color();
-    reflect_color();
-    refract_color();
-    specular_color();
-
-    return final_color;
+    }
 }
 
 }
@@ -670,6 +4544,22 @@ renderer::renderer(const scene& scene)
     , _mutex()
     , _tiles()
     , _threads()
+    , _mode(mode::recursive)
+    , _packets(1)
+    , _seed(0)
+    , _sampler(base::sampler::method::random)
+    , _cutoff(0.0f)
+    , _roulette(0)
+    , _stochastic(false)
+    , _light_samples(1)
+    , _analytic_shadows(false)
+    , _threshold(0.0f)
+    , _max_samples(0)
+    , _progressive(false)
+    , _budget(0.0)
+    , _cancelled(false)
+    , _traced(0)
+    , _statistics()
 {
 }
 
@@ -683,11 +4573,24 @@ void renderer::render ( ppm::writer& output
     const int   full_h = output.height();
     const int   half_w = full_w / 2;
     const int   half_h = full_h / 2;
-    const float scale  = 255.0f / static_cast<float>(samples);
+    const int   limit  = ( (_threshold <= 0.0f) && (_budget <= 0.0) ? samples
+                         : _max_samples > 0 ? std::max(samples, _max_samples)
+                         : _budget > 0.0    ? INT_MAX
+                         :                    samples * 4 );
+    const int   needed = ( (_threshold <= 0.0f) ? limit : samples );
+    const int   step   = ( _progressive ? PASS_SAMPLES : limit );
     const float fov    = (camera.fov * 512.0f) / static_cast<float>(full_h < full_w ? full_h : full_w);
     const vec3f right (vec3f::normalize(vec3f::cross(camera.direction, camera.normal)) * fov);
     const vec3f down  (vec3f::normalize(vec3f::cross(camera.direction, right        )) * fov);
     const vec3f corner(camera.direction - (right + down) * 0.5f);
+    const int   size   = full_w * full_h;
+    std::vector<col3f> pixels(size);
+    std::vector<float> sums(size);
+    std::vector<float> sums2(size);
+    std::vector<int>   counts(size);
+    base::profiler     timer("budget");
+    int                first = 0;
+    int                last  = 0;
 
     auto clamp = [](const int val) -> uint8_t
     {
@@ -703,6 +4606,44 @@ void renderer::render ( ppm::writer& output
         return val;
     };
 
+    auto luminance = [](const col3f& color) -> float
+    {
+        const float value = (color.r * 0.2126f) + (color.g * 0.7152f) + (color.b * 0.0722f);
+
+        return std::max(0.0f, std::min(value, 1.0f));
+    };
+
+    /*
+     * a pixel has converged once the standard error of the mean of its
+     * (clamped) luminance is below the noise threshold
+     */
+    auto converged = [&](const float sum, const float sum2, const int count) -> bool
+    {
+        if((_threshold <= 0.0f) || (count < 2)) {
+            return _threshold <= 0.0f;
+        }
+        const float mean     = sum / static_cast<float>(count);
+        const float variance = std::max(0.0f, (sum2 - (sum * mean)) / static_cast<float>(count - 1));
+
+        return (variance / static_cast<float>(count)) <= (_threshold * _threshold);
+    };
+
+    auto add_traced = [&](const uint64_t traced) -> void
+    {
+        const base::mutex_locker lock(_mutex);
+
+        _traced += traced;
+    };
+
+    auto add_statistics = [&](const raytracer::statistics& statistics) -> void
+    {
+        const base::mutex_locker lock(_mutex);
+
+        _statistics.shadow_rays += statistics.shadow_rays;
+        _statistics.occluded    += statistics.occluded;
+        _statistics.cache_hits  += statistics.cache_hits;
+    };
+
     auto push_tile = [&](const rec4i& tile) -> void
     {
         const base::mutex_locker lock(_mutex);
@@ -710,11 +4651,29 @@ void renderer::render ( ppm::writer& output
         return _tiles.push(tile);
     };
 
+    /*
+     * the first pass always completes, then the rendering stops at the
+     * next tile once cancelled or once the time budget has been spent
+     */
+    auto expired = [&]() -> bool
+    {
+        if(first == 0) {
+            return false;
+        }
+        if(_cancelled.load() != false) {
+            return true;
+        }
+        if((_budget > 0.0) && (timer.elapsed() >= _budget)) {
+            return true;
+        }
+        return false;
+    };
+
     auto pop_tile = [&](rec4i& tile) -> bool
     {
         const base::mutex_locker lock(_mutex);
 
-        if(_tiles.empty()) {
+        if(_tiles.empty() || expired()) {
             return false;
         }
         else {
@@ -740,46 +4699,160 @@ void renderer::render ( ppm::writer& output
         }
     };
 
+    auto primary_ray = [&](rt::raytracer& raytracer, const int x, const int y) -> rt::ray
+    {
+        const vec3f lens ( ( (right * raytracer.random1())
+                           + ( down * raytracer.random1()) ) * camera.dof );
+
+        const vec3f dir ( (right * (static_cast<float>(x - half_w + 1) + raytracer.random1()))
+                        + ( down * (static_cast<float>(y - half_h + 1) + raytracer.random1()))
+                        + corner );
+
+        return rt::ray(camera.position + lens, (dir * camera.focus - lens));
+    };
+
     auto render_tile = [&](rt::raytracer& raytracer, const rec4i& tile) -> void
     {
+        const int       packet_size = std::max(1, std::min(_packets, static_cast<int>(rt::ray_packet::LANES_MAX)));
+        const int       minimum = std::min(needed, last);
+        const int       maximum = std::min(limit, last);
+        rt::ray_packet  packet;
+        col3f           colors[rt::ray_packet::LANES_MAX];
+
         const int x1 = tile.x;
         const int y1 = tile.y;
         const int x2 = tile.x + tile.w;
         const int y2 = tile.y + tile.h;
-        const int col_stride = (3);
-        const int row_stride = (full_w * col_stride);
-        uint8_t*  buffer = output.data() + ((tile.y * row_stride) + (tile.x * col_stride));
+        uint64_t  traced = 0;
         for(int y = y1; y < y2; ++y) {
-            uint8_t* bufptr = buffer;
             for(int x = x1; x < x2; ++x) {
-                col3f color;
-                for(int sample = 0; sample < samples; ++sample) {
-                    const vec3f lens ( ( (right * raytracer.random1())
-                                       + ( down * raytracer.random1()) ) * camera.dof );
-
-                    const vec3f dir ( (right * (static_cast<float>(x - half_w + 1) + raytracer.random1()))
-                                    + ( down * (static_cast<float>(y - half_h + 1) + raytracer.random1()))
-                                    + corner );
-
-                    const ray primary_ray(camera.position + lens, (dir * camera.focus - lens));
+                const int      pixel  = (y * full_w) + x;
+                const uint32_t stream = (y << 16) | x;
+                col3f          color(pixels[pixel]);
+                float          sum    = sums[pixel];
+                float          sum2   = sums2[pixel];
+                int            sample = counts[pixel];
+                while((sample < minimum) || ((sample < maximum) && (converged(sum, sum2, sample) == false))) {
+                    const int count = std::min(packet_size, (sample < minimum ? minimum : maximum) - sample);
+                    for(int lane = 0; lane < count; ++lane) {
+                        raytracer.set_sample(stream, (sample + lane));
+                        packet.add(primary_ray(raytracer, x, y));
+                    }
+                    raytracer.set_sample(stream, sample, rt::raytracer::CAMERA_DIMENSIONS);
+                    if(count > 1) {
+                        raytracer.trace(packet, recursions, colors);
+                    }
+                    else {
+                        colors[0] = raytracer.trace(packet.rays[0], recursions);
+                    }
+                    for(int lane = 0; lane < count; ++lane) {
+                        const float value = luminance(colors[lane]);
+                        color += colors[lane];
+                        sum   += value;
+                        sum2  += value * value;
+                    }
+                    packet.clear();
+                    sample += count;
+                }
+                traced += (sample - counts[pixel]);
+                pixels[pixel] = color;
+                sums[pixel]   = sum;
+                sums2[pixel]  = sum2;
+                counts[pixel] = sample;
+            }
+        }
+        add_traced(traced);
+    };
 
-                    color += raytracer.trace(primary_ray, recursions);
+    /*
+     * one sample of every pixel of the tile is traced per wave, the pixels
+     * which have converged leaving the next waves
+     */
+    auto render_wave = [&](rt::wavefront& wavefront, const rec4i& tile) -> void
+    {
+        std::vector<col3f> previous(tile.w * tile.h);
+        rt::ray_queue      rays;
+        const col3f        weight(1.0f, 1.0f, 1.0f);
+        uint64_t           traced = 0;
+        for(int sample = first; sample < last; ++sample) {
+            for(int y = 0; y < tile.h; ++y) {
+                for(int x = 0; x < tile.w; ++x) {
+                    const int pixel = ((tile.y + y) * full_w) + (tile.x + x);
+                    if(counts[pixel] != sample) {
+                        continue;
+                    }
+                    if((sample >= needed) && (converged(sums[pixel], sums2[pixel], sample) != false)) {
+                        continue;
+                    }
+                    const uint32_t stream = ((tile.y + y) << 16) | (tile.x + x);
+                    wavefront.set_sample(stream, sample);
+                    rays.add(primary_ray(wavefront, tile.x + x, tile.y + y), weight, hit_result::DISTANCE_MAX, pixel, stream, rt::raytracer::CAMERA_DIMENSIONS);
+                    previous[(y * tile.w) + x] = pixels[pixel];
+                    ++counts[pixel];
+                }
+            }
+            if(rays.size() == 0) {
+                break;
+            }
+            traced += rays.size();
+            wavefront.set_sample(0, sample);
+            wavefront.trace(rays, recursions, _packets, pixels.data());
+            if(_threshold > 0.0f) {
+                for(int y = 0; y < tile.h; ++y) {
+                    for(int x = 0; x < tile.w; ++x) {
+                        const int pixel = ((tile.y + y) * full_w) + (tile.x + x);
+                        if(counts[pixel] == (sample + 1)) {
+                            const float value = luminance(pixels[pixel] - previous[(y * tile.w) + x]);
+                            sums[pixel]  += value;
+                            sums2[pixel] += value * value;
+                        }
+                    }
                 }
-                color *= scale;
-                *bufptr++ = clamp(static_cast<int>(color.r));
-                *bufptr++ = clamp(static_cast<int>(color.g));
-                *bufptr++ = clamp(static_cast<int>(color.b));
             }
-            buffer += row_stride;
+        }
+        add_traced(traced);
+    };
+
+    /*
+     * the accumulation buffer is resolved with the number of samples each
+     * pixel actually received
+     */
+    auto resolve = [&]() -> void
+    {
+        uint8_t* bufptr = output.data();
+        for(int pixel = 0; pixel < size; ++pixel) {
+            col3f color(pixels[pixel]);
+            if(counts[pixel] > 0) {
+                color *= (255.0f / static_cast<float>(counts[pixel]));
+            }
+            *bufptr++ = clamp(static_cast<int>(color.r));
+            *bufptr++ = clamp(static_cast<int>(color.g));
+            *bufptr++ = clamp(static_cast<int>(color.b));
         }
     };
 
     auto render_loop = [&]() -> void
     {
-        rt::raytracer raytracer(_scene);
-        rec4i         tile;
-        while(pop_tile(tile) != false) {
-            render_tile(raytracer, tile);
+        rec4i tile;
+        if(_mode == mode::wavefront) {
+            rt::wavefront wavefront(_scene, base::sampler(_sampler, _seed));
+            wavefront.set_termination(_cutoff, _roulette, _stochastic);
+            wavefront.set_light_samples(_light_samples);
+            wavefront.set_analytic_shadows(_analytic_shadows);
+            while(pop_tile(tile) != false) {
+                render_wave(wavefront, tile);
+            }
+            add_statistics(wavefront.get_statistics());
+        }
+        else {
+            rt::raytracer raytracer(_scene, recursions, base::sampler(_sampler, _seed));
+            raytracer.set_termination(_cutoff, _roulette, _stochastic);
+            raytracer.set_light_samples(_light_samples);
+            raytracer.set_analytic_shadows(_analytic_shadows);
+            while(pop_tile(tile) != false) {
+                render_tile(raytracer, tile);
+            }
+            add_statistics(raytracer.get_statistics());
         }
     };
 
@@ -803,12 +4876,37 @@ void renderer::render ( ppm::writer& output
         std::vector<std::thread>().swap(_threads);
     };
 
+    auto clear_tiles = [&]() -> void
+    {
+        std::queue<rec4i>().swap(_tiles);
+    };
+
+    /*
+     * the samples are traced by passes over the whole image, a single pass
+     * unless progressive, the passes stopping early once every pixel has
+     * converged
+     */
     auto execute = [&]() -> void
     {
-        create_tiles(64);
-        start_threads();
-        join_threads();
-        clear_threads();
+        _traced = 0;
+        _statistics = raytracer::statistics();
+        _cancelled.store(false);
+        for(first = 0; first < limit; first = last) {
+            const uint64_t traced = _traced;
+            last = first + std::min(step, limit - first);
+            if(expired()) {
+                break;
+            }
+            create_tiles(64);
+            start_threads();
+            join_threads();
+            clear_threads();
+            clear_tiles();
+            if(_traced == traced) {
+                break;
+            }
+        }
+        resolve();
     };
 
     return execute();
@@ -824,7 +4922,18 @@ namespace card {
 
 scene_factory::scene_factory(const std::string& scene_name)
     : _name(scene_name)
+    , _lattice(false)
+    , _instanced(false)
+    , _accents(0)
+    , _world_cols()
+    , _world_rows()
     , _world()
+    , _random_count(0)
+    , _random_seed(0)
+    , _random_density(0.5f)
+    , _random_clusters(0)
+    , _random_reflect(0.3f)
+    , _random_refract(0.1f)
     , _camera_position()
     , _camera_target()
     , _camera_top()
@@ -834,6 +4943,7 @@ scene_factory::scene_factory(const std::string& scene_name)
     , _light_position()
     , _light_color()
     , _light_power()
+    , _light_radius()
     , _sky_color()
     , _sky_ambient()
     , _floor_position()
@@ -854,18 +4964,40 @@ scene_factory::scene_factory(const std::string& scene_name)
     initialize();
 }
 
-std::shared_ptr<rt::scene> scene_factory::create(const std::string& scene_name)
+std::shared_ptr<rt::scene> scene_factory::create(const std::string& scene_name, const int threads)
 {
     scene_factory sb(scene_name);
 
-    return sb.build();
+    return sb.build(threads);
 }
 
 void scene_factory::initialize()
 {
-    for(auto& world : _world) {
-        world = 0;
+    auto has_prefix = [&](const std::string& prefix) -> bool
+    {
+        if(_name.compare(0, prefix.size(), prefix) == 0) {
+            _name = _name.substr(prefix.size());
+            return true;
+        }
+        return false;
+    };
+
+    if(has_prefix("lights:")) {
+        const size_t separator = _name.find(':');
+        char*        end       = nullptr;
+        _accents = static_cast<int>(::strtol(_name.c_str(), &end, 10));
+        if((separator == std::string::npos) || (end != (_name.c_str() + separator)) || (_accents <= 0)) {
+            throw std::runtime_error(std::string("invalid scene") + ' ' + '<' + "lights:" + _name + '>');
+        }
+        _name = _name.substr(separator + 1);
     }
+    if(has_prefix("static:")) {
+        _lattice = true;
+    }
+    else if(has_prefix("instanced:")) {
+        _instanced = true;
+    }
+    initialize_world<world>();
 
     _camera_position = rt::pos3f (+3.5f, -5.0f, +1.7f);
     _camera_target   = rt::pos3f (+0.25f, 0.0f, +1.0f);
@@ -876,6 +5008,7 @@ void scene_factory::initialize()
     _light_position  = rt::pos3f (+7.0f, -5.0f, +3.0f);
     _light_color     = rt::col3f (+0.90f, +0.95f, +1.00f);
     _light_power     = float     (20.0f);
+    _light_radius    = float     (0.75f);
     _sky_color       = rt::col3f (+0.25f, +0.75f, +1.00f);
     _sky_ambient     = rt::col3f (+0.35f, +0.35f, +0.35f);
     _floor_position  = rt::pos3f (0.0f, 0.0f, 0.0f);
@@ -886,13 +5019,13 @@ void scene_factory::initialize()
     _floor_reflect   = float     (0.2f);
     _floor_refract   = float     (0.0f);
     _floor_specular  = float     (0.0f);
-    _sphere_radius   = float     (1.0f);
-    _sphere_color    = rt::col3f (0.20f, 0.25f, 0.15f);
-    _sphere_reflect  = float     (0.5f);
-    _sphere_refract  = float     (0.0f);
-    _sphere_eta      = float     (1.0f);
-    _sphere_specular = float     (50.0f);
 
+    if(has_prefix("pbm:")) {
+        return initialize_bitmap(_name);
+    }
+    if(has_prefix("random:")) {
+        return initialize_random(_name);
+    }
     if(_name == "aek") {
         return initialize_aek();
     }
@@ -911,25 +5044,34 @@ void scene_factory::initialize()
     throw std::runtime_error(std::string("invalid scene") + ' ' + '<' + _name + '>');
 }
 
+/*
+ * the runtime scenes and the specialized ones share the same worlds
+ */
+template <typename World>
+void scene_factory::initialize_world()
+{
+    _world_cols = World::cols();
+    _world_rows = World::rows();
+    _world.assign((_world_cols * _world_rows), 0);
+    for(int row = 0; row < _world_rows; ++row) {
+        uint32_t val = World::row(row);
+        while(val != 0) {
+            const int col = __builtin_ctz(val);
+            _world[(((_world_rows - 1) - row) * _world_cols) + ((_world_cols - 1) - col)] = 1;
+            val &= (val - 1);
+        }
+    }
+    _sphere_radius   = World::sphere_radius();
+    _sphere_color    = World::sphere_color();
+    _sphere_reflect  = World::sphere_reflect();
+    _sphere_refract  = World::sphere_refract();
+    _sphere_eta      = World::sphere_eta();
+    _sphere_specular = World::sphere_specular();
+}
+
 void scene_factory::initialize_aek()
 {
-    int row = 0;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000010000000000;
-    _world[row++] = 0b00000000000000000000010000000000;
-    _world[row++] = 0b00000000111000011100010000000000;
-    _world[row++] = 0b00000000000100100010010001000000;
-    _world[row++] = 0b00000000000100100010010010000000;
-    _world[row++] = 0b00000000111100111110010100000000;
-    _world[row++] = 0b00000001000100100000011000000000;
-    _world[row++] = 0b00000001000100100000010100000000;
-    _world[row++] = 0b00000000111100011100010010000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
+    initialize_world<world_aek>();
 
     _camera_position = rt::pos3f (-7.0f, -16.0f,  +8.0f);
     _camera_target   = rt::pos3f (-1.0f,   0.0f,  +8.0f);
@@ -944,32 +5086,11 @@ void scene_factory::initialize_aek()
     _sky_ambient     = rt::col3f (+0.35f, +0.35f, +0.35f);
     _floor_scale     = float     (0.2f);
     _floor_reflect   = float     (0.0f);
-    _sphere_radius   = float     (1.0f);
-    _sphere_color    = rt::col3f (+0.0f, +0.0f, +0.0f);
-    _sphere_reflect  = float     (0.7f);
-    _sphere_refract  = float     (0.0f);
-    _sphere_specular = float     (99.0f);
 }
 
 void scene_factory::initialize_ponceto()
 {
-    int row = 0;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b11100011001001001110111101110110;
-    _world[row++] = 0b10010100101001010000100000101001;
-    _world[row++] = 0b10010100101101010000100000101001;
-    _world[row++] = 0b11100100101101010000111000101001;
-    _world[row++] = 0b10000100101011010000100000101001;
-    _world[row++] = 0b10000100101011010000100000101001;
-    _world[row++] = 0b10000011001001001110111100100110;
+    initialize_world<world_ponceto>();
 
     _camera_position = rt::pos3f (-19.0f, -19.0f, +15.0f);
     _camera_target   = rt::pos3f ( -5.0f,   0.0f,  +7.0f);
@@ -984,32 +5105,11 @@ void scene_factory::initialize_ponceto()
     _sky_ambient     = rt::col3f (+0.50f, +0.50f, +0.50f);
     _floor_scale     = float     (0.2f);
     _floor_reflect   = float     (0.3f);
-    _sphere_radius   = float     (0.75f);
-    _sphere_color    = rt::col3f (+1.0f, +0.8f, +0.0f);
-    _sphere_reflect  = float     (0.7f);
-    _sphere_refract  = float     (0.0f);
-    _sphere_specular = float     (99.0f);
 }
 
 void scene_factory::initialize_smiley()
 {
-    int row = 0;
-    _world[row++] = 0b00000000000001111110000000000000;
-    _world[row++] = 0b00000000000110000001100000000000;
-    _world[row++] = 0b00000000001000000000010000000000;
-    _world[row++] = 0b00000000010000000000001000000000;
-    _world[row++] = 0b00000000010001100110001000000000;
-    _world[row++] = 0b00000000100001100110000100000000;
-    _world[row++] = 0b00000000100000000000000100000000;
-    _world[row++] = 0b00000000100000000000000100000000;
-    _world[row++] = 0b00000000100000000000000100000000;
-    _world[row++] = 0b00000000100100000000100100000000;
-    _world[row++] = 0b00000000100010000001000100000000;
-    _world[row++] = 0b00000000010001111110001000000000;
-    _world[row++] = 0b00000000010000000000001000000000;
-    _world[row++] = 0b00000000001000000000010000000000;
-    _world[row++] = 0b00000000000110000001100000000000;
-    _world[row++] = 0b00000000000001111110000000000000;
+    initialize_world<world_smiley>();
 
     _camera_position = rt::pos3f (+19.0f, -17.0f, +15.0f);
     _camera_target   = rt::pos3f ( +2.0f,   0.0f, +8.0f);
@@ -1024,113 +5124,226 @@ void scene_factory::initialize_smiley()
     _sky_ambient     = rt::col3f (+0.50f, +0.50f, +0.50f);
     _floor_scale     = float     (0.3f);
     _floor_reflect   = float     (0.3f);
-    _sphere_radius   = float     (1.0f);
-    _sphere_color    = rt::col3f (+0.1f, +0.2f, +0.3f);
-    _sphere_reflect  = float     (0.7f);
-    _sphere_refract  = float     (0.0f);
-    _sphere_specular = float     (99.0f);
 }
 
-void scene_factory::initialize_simple()
-{
-    int row = 0;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000000000000000000000;
-    _world[row++] = 0b00000000000000100100000000000000;
+void scene_factory::initialize_simple()
+{
+    initialize_world<world_simple>();
+
+    _floor_scale     = float     (0.7f);
+    _floor_reflect   = float     (0.3f);
+}
+
+void scene_factory::initialize_spheres()
+{
+    _camera_position = rt::pos3f (+4.0f, -4.0f, +2.0f);
+    _camera_target   = rt::pos3f (+0.0f, +0.0f, +1.0f);
+    _camera_top      = rt::pos3f (+4.0f, -4.0f, +3.0f);
+    _camera_fov      = float     (0.002f);
+    _camera_dof      = float     (45.0f);
+    _camera_focus    = float     (5.0f);
+    _light_position  = rt::pos3f (-3.0f, -7.0f, +5.0f);
+    _light_color     = rt::col3f (+1.00f, +1.00f, +1.00f);
+    _light_power     = float     (15.0f);
+    _floor_color1    = rt::col3f (+0.10f, +0.10f, +0.10f);
+    _floor_color2    = rt::col3f (+0.90f, +0.90f, +0.90f);
+#if 0
+    _camera_position = rt::pos3f (+0.0f, -7.0f, +5.0f);
+    _camera_target   = rt::pos3f (+0.0f, +0.0f, +1.0f);
+    _camera_top      = rt::pos3f (+0.0f, -7.0f, +6.0f);
+    _camera_focus    = float     (7.0f);
+//  _floor_position  = rt::pos3f (-2.50f, +2.50f, -1.00f);
+//  _floor_normal    = rt::vec3f (+1.00f, -0.50f, +0.50f);
+#endif
+}
+
+/*
+ * the bitmap is laid out like the shipped worlds, one sphere per black
+ * pixel, and the default view is scaled to its size
+ */
+void scene_factory::initialize_bitmap(const std::string& filename)
+{
+    ppm::reader reader(filename);
+    int         width  = 0;
+    int         height = 0;
+    int         maxval = 0;
+
+    auto do_load = [&]() -> void
+    {
+        reader.open(width, height, maxval);
+        reader.fetch();
+        const uint8_t* pixels = reader.data();
+        _world_cols = width;
+        _world_rows = height;
+        _world.assign((static_cast<size_t>(width) * height), 0);
+        for(int row = 0; row < height; ++row) {
+            uint8_t* cells = &_world[static_cast<size_t>((height - 1) - row) * width];
+            for(int col = 0; col < width; ++col) {
+                cells[col] = *pixels++;
+            }
+        }
+        reader.close();
+    };
+
+    auto do_setup = [&]() -> void
+    {
+        const float cols  = static_cast<float>(width)  / static_cast<float>(world::cols());
+        const float rows  = static_cast<float>(height) / static_cast<float>(world::rows());
+        const float scale = std::max(1.0f, std::max(cols, rows));
+
+        _camera_position = rt::pos3f (-19.0f * scale, -19.0f * scale, +15.0f * scale);
+        _camera_target   = rt::pos3f ( -5.0f * scale,   0.0f * scale,  +7.0f * scale);
+        _camera_top      = rt::pos3f (-19.0f * scale, -19.0f * scale, +15.0f * scale + 1.0f);
+        _camera_fov      = float     (0.002f);
+        _camera_dof      = float     (256.0f);
+        _camera_focus    = float     ( 25.0f * scale);
+        _light_position  = rt::pos3f ( +5.0f * scale, -15.0f * scale, +15.0f * scale);
+        _light_power     = float     (+50.0f * scale);
+        _light_radius    = float     (0.75f * scale);
+        _floor_scale     = float     (0.2f / scale);
+        _floor_reflect   = float     (0.3f);
+    };
+
+    auto execute = [&]() -> void
+    {
+        do_load();
+        do_setup();
+    };
+
+    return execute();
+}
+
+/*
+ * random:{count}[:{seed}[:{density}[:{clusters}[:{reflect}[:{refract}]]]]]
+ * the density is given in spheres per square unit of floor, the remaining
+ * fraction of the material mix being diffuse
+ */
+void scene_factory::initialize_random(const std::string& parameters)
+{
+    std::vector<std::string> values;
+
+    auto do_split = [&]() -> void
+    {
+        size_t first = 0;
+        while(true) {
+            const size_t last = parameters.find(':', first);
+            values.push_back(parameters.substr(first, (last == std::string::npos ? last : (last - first))));
+            if(last == std::string::npos) {
+                break;
+            }
+            first = last + 1;
+        }
+    };
+
+    auto do_parse = [&]() -> void
+    {
+        try {
+            const size_t count = values.size();
+            if(count > 6) {
+                throw std::invalid_argument("too many parameters");
+            }
+            _random_count    = (count > 0 ? std::stoi(values[0]) : 0);
+            _random_seed     = (count > 1 ? static_cast<uint32_t>(std::stoul(values[1])) : 0);
+            _random_density  = (count > 2 ? std::stof(values[2]) : _random_density);
+            _random_clusters = (count > 3 ? std::stoi(values[3]) : _random_clusters);
+            _random_reflect  = (count > 4 ? std::stof(values[4]) : _random_reflect);
+            _random_refract  = (count > 5 ? std::stof(values[5]) : _random_refract);
+        }
+        catch(const std::logic_error&) {
+            throw std::runtime_error(std::string("invalid scene") + ' ' + '<' + "random:" + parameters + '>');
+        }
+        if((_random_count <= 0) || (_random_density <= 0.0f) || (_random_clusters < 0)
+        || (_random_reflect < 0.0f) || (_random_refract < 0.0f) || ((_random_reflect + _random_refract) > 1.0f)) {
+            throw std::runtime_error(std::string("invalid scene") + ' ' + '<' + "random:" + parameters + '>');
+        }
+    };
+
+    auto do_setup = [&]() -> void
+    {
+        const float side  = ::sqrtf(static_cast<float>(_random_count) / _random_density);
+        const float scale = std::max(1.0f, (side / 8.0f));
+
+        _camera_position = rt::pos3f (+4.0f * scale, -4.0f * scale, +2.0f * scale);
+        _camera_target   = rt::pos3f (+0.0f, +0.0f, +0.0f);
+        _camera_top      = rt::pos3f (+4.0f * scale, -4.0f * scale, +2.0f * scale + 1.0f);
+        _camera_fov      = float     (0.002f);
+        _camera_dof      = float     (99.0f);
+        _camera_focus    = float     (5.0f * scale);
+        _light_position  = rt::pos3f (-3.0f * scale, -7.0f * scale, +5.0f * scale);
+        _light_color     = rt::col3f (+1.00f, +1.00f, +1.00f);
+        _light_power     = float     (15.0f * scale);
+        _light_radius    = float     (0.75f * scale);
+        _floor_color1    = rt::col3f (+0.10f, +0.10f, +0.10f);
+        _floor_color2    = rt::col3f (+0.90f, +0.90f, +0.90f);
+        _floor_scale     = float     (1.0f / scale);
+    };
 
-    _floor_scale     = float     (0.7f);
-    _floor_reflect   = float     (0.3f);
-    _sphere_radius   = float     (1.0f);
-    _sphere_color    = rt::col3f (0.15f, 0.35f, 0.25f);
-    _sphere_reflect  = float     (0.20f);
-    _sphere_refract  = float     (0.70f);
-    _sphere_eta      = float     (0.70f);
-    _sphere_specular = float     (90.0f);
-}
+    auto execute = [&]() -> void
+    {
+        do_split();
+        do_parse();
+        do_setup();
+    };
 
-void scene_factory::initialize_spheres()
-{
-    _camera_position = rt::pos3f (+4.0f, -4.0f, +2.0f);
-    _camera_target   = rt::pos3f (+0.0f, +0.0f, +1.0f);
-    _camera_top      = rt::pos3f (+4.0f, -4.0f, +3.0f);
-    _camera_fov      = float     (0.002f);
-    _camera_dof      = float     (45.0f);
-    _camera_focus    = float     (5.0f);
-    _light_position  = rt::pos3f (-3.0f, -7.0f, +5.0f);
-    _light_color     = rt::col3f (+1.00f, +1.00f, +1.00f);
-    _light_power     = float     (15.0f);
-    _floor_color1    = rt::col3f (+0.10f, +0.10f, +0.10f);
-    _floor_color2    = rt::col3f (+0.90f, +0.90f, +0.90f);
-#if 0
-    _camera_position = rt::pos3f (+0.0f, -7.0f, +5.0f);
-    _camera_target   = rt::pos3f (+0.0f, +0.0f, +1.0f);
-    _camera_top      = rt::pos3f (+0.0f, -7.0f, +6.0f);
-    _camera_focus    = float     (7.0f);
-//  _floor_position  = rt::pos3f (-2.50f, +2.50f, -1.00f);
-//  _floor_normal    = rt::vec3f (+1.00f, -0.50f, +0.50f);
-#endif
+    return execute();
 }
 
-std::shared_ptr<rt::scene> scene_factory::build()
+std::shared_ptr<rt::scene> scene_factory::build(const int threads)
 {
     auto add_floor = [&](rt::scene& scene) -> void
     {
-        std::shared_ptr<rt::plane> obj = std::make_shared<rt::plane>(_floor_position, _floor_normal, _floor_scale);
-        obj->set_color1( _floor_color1);
-        obj->set_color2( _floor_color2);
-        obj->set_reflect( _floor_reflect);
-        obj->set_refract( _floor_refract);
-        obj->set_specular( _floor_specular);
+        const rt::material material ( rt::col3f()
+                                    , _floor_color1
+                                    , _floor_color2
+                                    , _floor_reflect
+                                    , _floor_refract
+                                    , 1.0f
+                                    , _floor_specular );
+
+        rt::plane& obj(scene.create<rt::plane>(_floor_position, _floor_normal, _floor_scale));
+        obj.set_material(scene.add_material(material));
 
         scene.add(obj);
     };
 
     auto add_spheres = [&](rt::scene& scene) -> void
     {
-        constexpr int cols         = 32;
-        constexpr int rows         = countof(_world);
-        constexpr float col_offset = -16.0f;
-        constexpr float row_offset =   0.0f;
+        const int       cols       = _world_cols;
+        const int       rows       = _world_rows;
+        const float     col_offset = -static_cast<float>(cols / 2);
+        const float     row_offset = world::row_offset();
+        const rt::pos3f origin((col_offset + 1.0f), 0.0f, (row_offset + 1.0f));
+
+        const rt::material sphere_material ( _sphere_color
+                                           , rt::col3f()
+                                           , rt::col3f()
+                                           , _sphere_reflect
+                                           , _sphere_refract
+                                           , _sphere_eta
+                                           , _sphere_specular );
+
+        const int material = scene.add_material(sphere_material);
+        if((_lattice != false) && (build_lattice(scene, material) != false)) {
+            return;
+        }
+        if(_instanced != false) {
+            return build_instances(scene, material);
+        }
 
+        rt::sphere_grid& obj(scene.create<rt::sphere_grid>(origin, cols, rows, _sphere_radius));
+        const uint8_t* cells = _world.data();
         for(int row = 0; row < rows; ++row) {
-            uint32_t constexpr lsb = (1 << 0);
-            uint32_t           val = _world[row];
-            if(val == 0) {
-                continue;
-            }
             for(int col = 0; col < cols; ++col) {
-                if(val & lsb) {
-                    const float x = static_cast<float>(cols - col) + col_offset;
-                    const float y = static_cast<float>(0);
-                    const float z = static_cast<float>(rows - row) + row_offset;
-                    const float r = _sphere_radius;
-                    std::shared_ptr<rt::sphere> obj = std::make_shared<rt::sphere>(rt::pos3f(x, y, z), r);
-                    obj->set_color0(_sphere_color);
-                    obj->set_reflect(_sphere_reflect);
-                    obj->set_refract(_sphere_refract);
-                    obj->set_eta(_sphere_eta);
-                    obj->set_specular(_sphere_specular);
-
-                    scene.add(obj);
-                }
-                if((val >>= 1) == 0) {
-                    break;
+                if(*cells++ != 0) {
+                    obj.set(col, row);
                 }
             }
         }
+        obj.set_material(material);
+
+        if(obj.count() > 0) {
+            scene.add(obj);
+        }
     };
 
     const rt::camera camera ( _camera_position
@@ -1142,7 +5355,8 @@ std::shared_ptr<rt::scene> scene_factory::build()
 
     const rt::light light   ( _light_position
                             , _light_color
-                            , _light_power );
+                            , _light_power
+                            , _light_radius );
 
     const rt::sky sky       ( _sky_color
                             , _sky_ambient );
@@ -1168,9 +5382,129 @@ std::shared_ptr<rt::scene> scene_factory::build()
     if(_name == "spheres") {
         build_spheres(*scene);
     }
+    if(_random_count > 0) {
+        build_random(*scene);
+    }
+    if(_accents > 0) {
+        build_accents(*scene);
+    }
+    scene->compile(threads);
+
     return scene;
 }
 
+/*
+ * the shipped worlds are replaced by their compile-time specialization,
+ * the other scenes keeping the generic path
+ */
+bool scene_factory::build_lattice(rt::scene& scene, const int material)
+{
+    auto add_lattice = [&](rt::object& lattice) -> bool
+    {
+        lattice.set_material(material);
+        scene.add(lattice);
+        return true;
+    };
+
+    if(_name == "aek") {
+        return add_lattice(scene.create<rt::sphere_lattice<world_aek>>());
+    }
+    if(_name == "ponceto") {
+        return add_lattice(scene.create<rt::sphere_lattice<world_ponceto>>());
+    }
+    if(_name == "smiley") {
+        return add_lattice(scene.create<rt::sphere_lattice<world_smiley>>());
+    }
+    if(_name == "simple") {
+        return add_lattice(scene.create<rt::sphere_lattice<world_simple>>());
+    }
+    return false;
+}
+
+/*
+ * the world is cut into glyphs at its empty columns, identical glyphs are
+ * built once and shared by all of their instances
+ */
+void scene_factory::build_instances(rt::scene& scene, const int material)
+{
+    const int       cols       = _world_cols;
+    const int       rows       = _world_rows;
+    const float     col_offset = -static_cast<float>(cols / 2);
+    const float     row_offset = world::row_offset();
+    const rt::pos3f origin((col_offset + 1.0f), 0.0f, (row_offset + 1.0f));
+
+    using pattern = std::vector<uint8_t>;
+
+    std::vector<std::pair<pattern, rt::glyph*>> glyphs;
+
+    auto get_bits = [&](const int col, const int row) -> uint8_t
+    {
+        return _world[(row * cols) + col];
+    };
+
+    auto is_empty = [&](const int col) -> bool
+    {
+        for(int row = 0; row < rows; ++row) {
+            if(get_bits(col, row) != 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    auto get_glyph = [&](const int first, const int last) -> rt::glyph&
+    {
+        pattern bits;
+        for(int row = 0; row < rows; ++row) {
+            for(int col = first; col < last; ++col) {
+                bits.push_back(get_bits(col, row));
+            }
+        }
+        for(auto& glyph : glyphs) {
+            if(glyph.first == bits) {
+                return *glyph.second;
+            }
+        }
+        rt::glyph& glyph(scene.create<rt::glyph>(_sphere_radius));
+        for(int row = 0; row < rows; ++row) {
+            for(int col = first; col < last; ++col) {
+                if(get_bits(col, row) != 0) {
+                    glyph.add(rt::pos3f(static_cast<float>(col - first), 0.0f, static_cast<float>(row)));
+                }
+            }
+        }
+        glyph.compile();
+        glyphs.emplace_back(bits, &glyph);
+        return glyph;
+    };
+
+    auto add_instance = [&](const int first, const int last) -> void
+    {
+        const rt::vec3f offset((origin.x + static_cast<float>(first)), origin.y, origin.z);
+        rt::instance&   obj(scene.create<rt::instance>(get_glyph(first, last), offset));
+        obj.set_material(material);
+        scene.add(obj);
+    };
+
+    auto execute = [&]() -> void
+    {
+        int col = 0;
+        while(col < cols) {
+            if(is_empty(col)) {
+                ++col;
+                continue;
+            }
+            const int first = col;
+            while((col < cols) && (is_empty(col) == false)) {
+                ++col;
+            }
+            add_instance(first, col);
+        }
+    };
+
+    return execute();
+}
+
 void scene_factory::build_aek(rt::scene& scene)
 {
 }
@@ -1197,12 +5531,16 @@ void scene_factory::build_spheres(rt::scene& scene)
                           , const float      eta
                           , const float      specular )
     {
-        std::shared_ptr<rt::sphere> obj = std::make_shared<rt::sphere>(position, 1.0f);
-        obj->set_color0(color);
-        obj->set_reflect(reflect);
-        obj->set_refract(refract);
-        obj->set_eta(eta);
-        obj->set_specular(specular);
+        const rt::material material ( color
+                                    , rt::col3f()
+                                    , rt::col3f()
+                                    , reflect
+                                    , refract
+                                    , eta
+                                    , specular );
+
+        rt::sphere& obj(scene.create<rt::sphere>(position, 1.0f));
+        obj.set_material(scene.add_material(material));
         scene.add(obj);
     };
 
@@ -1211,6 +5549,118 @@ void scene_factory::build_spheres(rt::scene& scene)
     add_sphere(rt::pos3f(+1.5f, +1.5f, +1.0f), 1.0f, rt::col3f(0.0f, 0.8f, 0.0f), 0.3f, 0.3f, 0.50f, 75.0f);
 }
 
+/*
+ * the uniform and normal draws are derived from the raw mt19937 output,
+ * which is fully specified, so that a seed gives the same scene everywhere
+ */
+void scene_factory::build_random(rt::scene& scene)
+{
+    constexpr int          PALETTE = 8;
+    base::mersenne_twister generator(_random_seed);
+    const float            side = ::sqrtf(static_cast<float>(_random_count) / _random_density);
+    int                    diffuse_materials[PALETTE];
+    int                    reflect_materials[PALETTE];
+    int                    refract_materials[PALETTE];
+
+    auto uniform = [&]() -> float
+    {
+        return static_cast<float>(generator() >> 8) * (1.0f / 16777216.0f);
+    };
+
+    auto normal = [&]() -> float
+    {
+        const float u1 = std::max(uniform(), FLT_MIN);
+        const float u2 = uniform();
+        return ::sqrtf(-2.0f * ::logf(u1)) * ::cosf(6.2831853f * u2);
+    };
+
+    auto add_materials = [&]() -> void
+    {
+        for(int index = 0; index < PALETTE; ++index) {
+            const rt::col3f color((0.1f + 0.8f * uniform()), (0.1f + 0.8f * uniform()), (0.1f + 0.8f * uniform()));
+            diffuse_materials[index] = scene.add_material(rt::material(color, rt::col3f(), rt::col3f(), 0.0f, 0.0f, 1.00f, 20.0f));
+            reflect_materials[index] = scene.add_material(rt::material(color, rt::col3f(), rt::col3f(), 0.7f, 0.0f, 1.00f, 90.0f));
+            refract_materials[index] = scene.add_material(rt::material(color, rt::col3f(), rt::col3f(), 0.1f, 0.8f, 0.91f, 90.0f));
+        }
+    };
+
+    auto add_spheres = [&]() -> void
+    {
+        std::vector<rt::pos3f> clusters;
+        for(int index = 0; index < _random_clusters; ++index) {
+            clusters.emplace_back(((uniform() - 0.5f) * side), ((uniform() - 0.5f) * side), 0.0f);
+        }
+        const float spread = side / (2.0f * ::sqrtf(static_cast<float>(std::max(_random_clusters, 1))));
+        for(int index = 0; index < _random_count; ++index) {
+            const float radius = 0.15f + 0.25f * uniform();
+            float       x      = 0.0f;
+            float       y      = 0.0f;
+            if(clusters.empty()) {
+                x = (uniform() - 0.5f) * side;
+                y = (uniform() - 0.5f) * side;
+            }
+            else {
+                const rt::pos3f& center(clusters[static_cast<int>(uniform() * clusters.size()) % clusters.size()]);
+                x = center.x + normal() * spread;
+                y = center.y + normal() * spread;
+            }
+            const float z    = radius + 2.0f * uniform() * uniform();
+            const float pick = uniform();
+            const int   slot = static_cast<int>(uniform() * PALETTE) % PALETTE;
+            const int   material = ( pick < _random_reflect                     ? reflect_materials[slot]
+                                   : pick < _random_reflect + _random_refract   ? refract_materials[slot]
+                                   :                                              diffuse_materials[slot] );
+            rt::sphere& obj(scene.create<rt::sphere>(rt::pos3f(x, y, z), radius));
+            obj.set_material(material);
+            scene.add(obj);
+        }
+    };
+
+    auto execute = [&]() -> void
+    {
+        add_materials();
+        add_spheres();
+    };
+
+    return execute();
+}
+
+/*
+ * the accent lights are spread in front of the world, their power being
+ * shared so that they add up to a fraction of the key light
+ */
+void scene_factory::build_accents(rt::scene& scene)
+{
+    const float cols  = static_cast<float>(_world_cols);
+    const float rows  = static_cast<float>(_world_rows);
+    const float power = (_light_power * 0.25f) / static_cast<float>(_accents);
+
+    auto uniform = [&](const int index, const int dimension) -> float
+    {
+        return base::randomizer::uniform(0, static_cast<uint32_t>(index), 0, static_cast<uint32_t>(dimension));
+    };
+
+    auto add_lights = [&]() -> void
+    {
+        for(int index = 0; index < _accents; ++index) {
+            const rt::pos3f position ( ((uniform(index, 0) - 0.5f) * (cols + 8.0f))
+                                     , (-1.0f - (uniform(index, 1) * 6.0f))
+                                     , (0.5f + (uniform(index, 2) * (rows + 2.0f))) );
+            const rt::col3f color    ( (0.4f + (0.6f * uniform(index, 3)))
+                                     , (0.4f + (0.6f * uniform(index, 4)))
+                                     , (0.4f + (0.6f * uniform(index, 5))) );
+            scene.add_light(rt::light(position, color, power, (_light_radius * 0.5f)));
+        }
+    };
+
+    auto execute = [&]() -> void
+    {
+        add_lights();
+    };
+
+    return execute();
+}
+
 }
 
 // ---------------------------------------------------------------------------
@@ -1219,6 +5669,24 @@ void scene_factory::build_spheres(rt::scene& scene)
 
 namespace card {
 
+namespace {
+
+std::atomic<rt::renderer*> interruptible(nullptr);
+
+/*
+ * an interrupt cancels a progressive rendering which then resolves what it
+ * has accumulated so far
+ */
+void interrupt(int)
+{
+    rt::renderer* renderer = interruptible.load();
+    if(renderer != nullptr) {
+        renderer->cancel();
+    }
+}
+
+}
+
 generator::generator(int argc, char* argv[])
     : base::console(std::cin, std::cout, std::cerr)
     , base::program(argc, argv)
@@ -1230,6 +5698,19 @@ generator::generator(int argc, char* argv[])
     , _samples(64)
     , _recursions(8)
     , _threads(1)
+    , _packets(8)
+    , _seed(0)
+    , _sampler(base::sampler::method::random)
+    , _cutoff(0.0f)
+    , _roulette(0)
+    , _stochastic(false)
+    , _light_samples(1)
+    , _analytic_shadows(false)
+    , _threshold(0.0f)
+    , _max_samples(0)
+    , _progressive(false)
+    , _budget(0.0)
+    , _mode(rt::renderer::mode::recursive)
 {
 }
 
@@ -1262,16 +5743,61 @@ void generator::main()
         profiler.reset();
     };
 
+    auto build = [&]() -> std::shared_ptr<rt::scene>
+    {
+        base::profiler builder("build");
+
+        auto statistics = [&](const char* name, const rt::bvh& bvh) -> void
+        {
+            cout() << builder.name() << ':' << ' ' << name << ' ' << bvh.get_nodes().size() << " nodes" << ',' << ' ' << "sah cost " << bvh.get_cost() << std::endl;
+        };
+
+        cout() << builder.name() << ':' << ' ' << "building ..." << std::endl;
+        const std::shared_ptr<rt::scene> scene(scene_factory::create(_scene, _threads));
+        cout() << builder.name() << ':' << ' ' << (builder.elapsed() * 1000.0) << "ms" << std::endl;
+        statistics("spheres", scene->get_spheres_bvh());
+        statistics("objects", scene->get_objects_bvh());
+        return scene;
+    };
+
     auto render = [&]() -> void
     {
         ppm::writer output(_output);
-        const std::shared_ptr<rt::scene> scene(scene_factory::create(_scene));
+        const std::shared_ptr<rt::scene> scene(build());
         rt::renderer renderer(*scene);
 
         output.open(_card_w, _card_h, 255);
         begin();
+        renderer.set_mode(_mode);
+        renderer.set_packets(_packets);
+        renderer.set_seed(_seed);
+        renderer.set_sampler(_sampler);
+        renderer.set_termination(_cutoff, _roulette, _stochastic);
+        renderer.set_light_samples(_light_samples);
+        renderer.set_analytic_shadows(_analytic_shadows);
+        renderer.set_adaptive(_threshold, _max_samples);
+        renderer.set_progressive(_progressive, _budget);
+        if(_progressive) {
+            interruptible.store(&renderer);
+            std::signal(SIGINT, interrupt);
+        }
         renderer.render(output, _samples, _recursions, _threads);
+        if(_progressive) {
+            std::signal(SIGINT, SIG_DFL);
+            interruptible.store(nullptr);
+        }
         end();
+        if((_threshold > 0.0f) || _progressive) {
+            const double pixels = static_cast<double>(_card_w) * static_cast<double>(_card_h);
+            cout() << profiler.name() << ':' << ' ' << (static_cast<double>(renderer.get_traced()) / pixels) << " samples per pixel" << std::endl;
+        }
+        /* shadows statistics */ {
+            const rt::raytracer::statistics& statistics(renderer.get_statistics());
+            if(statistics.occluded > 0) {
+                const double hit_rate = static_cast<double>(statistics.cache_hits) / static_cast<double>(statistics.occluded);
+                cout() << profiler.name() << ':' << ' ' << statistics.shadow_rays << " shadow rays, " << statistics.occluded << " occluded, " << (hit_rate * 100.0) << "% occluder cache hits" << std::endl;
+            }
+        }
         output.store();
         output.close();
     };
@@ -1378,6 +5904,125 @@ bool generator::parse()
         }
     };
 
+    auto set_packets = [&](const std::string& argument) -> void
+    {
+        _packets = get_int_val(argument);
+        if((_packets <= 0) || (_packets > rt::ray_packet::LANES_MAX)) {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_seed = [&](const std::string& argument) -> void
+    {
+        const std::string seed(get_str_val(argument));
+        char*             end = nullptr;
+        _seed = static_cast<uint32_t>(::strtoul(seed.c_str(), &end, 10));
+        if(seed.empty() || (*end != '\0')) {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_sampler = [&](const std::string& argument) -> void
+    {
+        const std::string sampler(get_str_val(argument));
+        if(sampler == "random") {
+            _sampler = base::sampler::method::random;
+        }
+        else if(sampler == "sobol") {
+            _sampler = base::sampler::method::sobol;
+        }
+        else if(sampler == "bluenoise") {
+            _sampler = base::sampler::method::bluenoise;
+        }
+        else {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_cutoff = [&](const std::string& argument) -> void
+    {
+        const std::string cutoff(get_str_val(argument));
+        char*             end = nullptr;
+        _cutoff = ::strtof(cutoff.c_str(), &end);
+        if(cutoff.empty() || (*end != '\0') || (_cutoff < 0.0f) || (_cutoff >= 1.0f)) {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_roulette = [&](const std::string& argument) -> void
+    {
+        _roulette = get_int_val(argument);
+        if(_roulette <= 0) {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_stochastic = [&](const std::string& argument) -> void
+    {
+        _stochastic = true;
+    };
+
+    auto set_light_samples = [&](const std::string& argument) -> void
+    {
+        _light_samples = get_int_val(argument);
+        if((_light_samples <= 0) || (_light_samples > rt::raytracer::LIGHTS_MAX)) {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_analytic_shadows = [&](const std::string& argument) -> void
+    {
+        _analytic_shadows = true;
+    };
+
+    auto set_threshold = [&](const std::string& argument) -> void
+    {
+        const std::string threshold(get_str_val(argument));
+        char*             end = nullptr;
+        _threshold = ::strtof(threshold.c_str(), &end);
+        if(threshold.empty() || (*end != '\0') || (_threshold < 0.0f)) {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_max_samples = [&](const std::string& argument) -> void
+    {
+        _max_samples = get_int_val(argument);
+        if(_max_samples <= 0) {
+            invalid_argument(argument);
+        }
+    };
+
+    auto set_progressive = [&](const std::string& argument) -> void
+    {
+        _progressive = true;
+    };
+
+    auto set_budget = [&](const std::string& argument) -> void
+    {
+        const std::string budget(get_str_val(argument));
+        char*             end = nullptr;
+        _budget = ::strtod(budget.c_str(), &end);
+        if(budget.empty() || (*end != '\0') || (_budget <= 0.0)) {
+            invalid_argument(argument);
+        }
+        _progressive = true;
+    };
+
+    auto set_mode = [&](const std::string& argument) -> void
+    {
+        const std::string mode(get_str_val(argument));
+        if(mode == "recursive") {
+            _mode = rt::renderer::mode::recursive;
+        }
+        else if(mode == "wavefront") {
+            _mode = rt::renderer::mode::wavefront;
+        }
+        else {
+            invalid_argument(argument);
+        }
+    };
+
     auto execute = [&]() -> bool
     {
         int argi = 0;
@@ -1412,6 +6057,45 @@ bool generator::parse()
             else if(has_option(argument, "--threads=")) {
                 set_threads(argument);
             }
+            else if(has_option(argument, "--packets=")) {
+                set_packets(argument);
+            }
+            else if(has_option(argument, "--seed=")) {
+                set_seed(argument);
+            }
+            else if(has_option(argument, "--sampler=")) {
+                set_sampler(argument);
+            }
+            else if(has_option(argument, "--cutoff=")) {
+                set_cutoff(argument);
+            }
+            else if(has_option(argument, "--roulette=")) {
+                set_roulette(argument);
+            }
+            else if(argument == "--stochastic") {
+                set_stochastic(argument);
+            }
+            else if(has_option(argument, "--light-samples=")) {
+                set_light_samples(argument);
+            }
+            else if(argument == "--analytic-shadows") {
+                set_analytic_shadows(argument);
+            }
+            else if(has_option(argument, "--noise-threshold=")) {
+                set_threshold(argument);
+            }
+            else if(has_option(argument, "--max-samples=")) {
+                set_max_samples(argument);
+            }
+            else if(argument == "--progressive") {
+                set_progressive(argument);
+            }
+            else if(has_option(argument, "--time-budget=")) {
+                set_budget(argument);
+            }
+            else if(has_option(argument, "--mode=")) {
+                set_mode(argument);
+            }
             else {
                 invalid_argument(argument);
             }
@@ -1437,8 +6121,22 @@ void generator::usage()
     cout() << "    --width={int}           the card width"                   << std::endl;
     cout() << "    --height={int}          the card height"                  << std::endl;
     cout() << "    --samples={int}         samples per pixel"                << std::endl;
+    cout() << "    --cutoff={flt}          path weight cutoff"               << std::endl;
+    cout() << "    --roulette={int}        russian roulette bounce"          << std::endl;
+    cout() << "    --stochastic            one of reflect or refract"        << std::endl;
+    cout() << "    --light-samples={int}   shadow rays per hit"              << std::endl;
+    cout() << "    --analytic-shadows      cone traced spherical lights"     << std::endl;
+    cout() << "    --noise-threshold={flt} adaptive noise threshold"         << std::endl;
+    cout() << "    --max-samples={int}     adaptive or budget maximum"       << std::endl;
+    cout() << "    --progressive           render by passes of samples"      << std::endl;
+    cout() << "    --time-budget={flt}     progressive budget in seconds"    << std::endl;
+    cout() << "                            (--samples is then a minimum)"    << std::endl;
     cout() << "    --recursions={int}      maximum recursions level"         << std::endl;
     cout() << "    --threads={int}         number of threads"                << std::endl;
+    cout() << "    --packets={int}         rays per packet"                  << std::endl;
+    cout() << "    --seed={int}            the random seed"                  << std::endl;
+    cout() << "    --sampler={sampler}     the sampling method"              << std::endl;
+    cout() << "    --mode={mode}           the rendering mode"               << std::endl;
     cout() << ""                                                             << std::endl;
     cout() << "Scenes:"                                                      << std::endl;
     cout() << ""                                                             << std::endl;
@@ -1447,6 +6145,22 @@ void generator::usage()
     cout() << "    - smiley"                                                 << std::endl;
     cout() << "    - simple"                                                 << std::endl;
     cout() << "    - spheres"                                                << std::endl;
+    cout() << "    - static:{scene}        compile-time specialized scene"   << std::endl;
+    cout() << "    - instanced:{scene}     glyph instancing scene"           << std::endl;
+    cout() << "    - lights:{count}:{scene} accent lights"                   << std::endl;
+    cout() << "    - pbm:{file}            sphere field from a P1/P4 bitmap" << std::endl;
+    cout() << "    - random:{count}:{seed} procedural stress scene"          << std::endl;
+    cout() << ""                                                             << std::endl;
+    cout() << "Modes:"                                                       << std::endl;
+    cout() << ""                                                             << std::endl;
+    cout() << "    - recursive"                                              << std::endl;
+    cout() << "    - wavefront"                                              << std::endl;
+    cout() << ""                                                             << std::endl;
+    cout() << "Samplers:"                                                    << std::endl;
+    cout() << ""                                                             << std::endl;
+    cout() << "    - random"                                                 << std::endl;
+    cout() << "    - sobol"                                                  << std::endl;
+    cout() << "    - bluenoise"                                              << std::endl;
     cout() << ""                                                             << std::endl;
 }
 
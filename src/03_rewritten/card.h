@@ -14,11 +14,123 @@
 
 namespace base {
 
-using arglist                    = std::vector<std::string>;
-using steady_clock               = std::chrono::steady_clock;
-using mersenne_twister           = std::mt19937;
-using uniform_float_distribution = std::uniform_real_distribution<float>;
-using mutex_locker               = std::lock_guard<std::mutex>;
+using arglist          = std::vector<std::string>;
+using steady_clock     = std::chrono::steady_clock;
+using mersenne_twister = std::mt19937;
+using mutex_locker     = std::lock_guard<std::mutex>;
+
+}
+
+// ---------------------------------------------------------------------------
+// base::aligned_allocator
+// ---------------------------------------------------------------------------
+
+namespace base {
+
+template <typename T, size_t Alignment = 64>
+class aligned_allocator
+{
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() = default;
+
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&)
+    {
+    }
+
+    T* allocate(const size_t count)
+    {
+        void* pointer = nullptr;
+        if(::posix_memalign(&pointer, Alignment, (count * sizeof(T))) != 0) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(pointer);
+    }
+
+    void deallocate(T* pointer, const size_t count)
+    {
+        ::free(pointer);
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U, Alignment>&) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const aligned_allocator<U, Alignment>&) const
+    {
+        return false;
+    }
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// base::arena
+// ---------------------------------------------------------------------------
+
+namespace base {
+
+class arena
+{
+public:
+    arena(const size_t chunk_size = 65536);
+
+    arena(const arena&) = delete;
+
+    arena& operator=(const arena&) = delete;
+
+    virtual ~arena();
+
+    void* allocate(const size_t size, const size_t alignment);
+
+    void clear();
+
+    template <typename T, typename... Args>
+    T& create(Args&&... args)
+    {
+        void* storage = allocate(sizeof(T), alignof(T));
+        T*    object  = new (storage) T(std::forward<Args>(args)...);
+        if(std::is_trivially_destructible<T>::value == false) {
+            _destructors.push_back(destructor { object, [](void* pointer) -> void { static_cast<T*>(pointer)->~T(); } });
+        }
+        return *object;
+    }
+
+    auto size() const -> size_t
+    {
+        return _size;
+    }
+
+protected:
+    struct chunk
+    {
+        uint8_t* data;
+        size_t   size;
+        size_t   used;
+    };
+
+    struct destructor
+    {
+        void* object;
+        void (*function)(void*);
+    };
+
+    std::vector<chunk>      _chunks;
+    std::vector<destructor> _destructors;
+    size_t                  _chunk_size;
+    size_t                  _size;
+};
 
 }
 
@@ -68,18 +180,89 @@ namespace base {
 class randomizer
 {
 public:
-    randomizer(const float min, const float max);
+    static auto mix(uint32_t value) -> uint32_t
+    {
+        value ^= (value >> 16);
+        value *= UINT32_C(0x7feb352d);
+        value ^= (value >> 15);
+        value *= UINT32_C(0x846ca68b);
+        value ^= (value >> 16);
+        return value;
+    }
+
+    static auto hash(const uint32_t seed, const uint32_t stream, const uint32_t sample, const uint32_t dimension) -> uint32_t
+    {
+        return mix(mix(mix(mix(seed) ^ stream) ^ sample) ^ dimension);
+    }
+
+    static auto uniform(const uint32_t seed, const uint32_t stream, const uint32_t sample, const uint32_t dimension) -> float
+    {
+        return static_cast<float>(hash(seed, stream, sample, dimension) >> 8) * (1.0f / 16777216.0f);
+    }
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// base::sampler
+// ---------------------------------------------------------------------------
+
+namespace base {
+
+class sampler
+{
+public:
+    enum class method
+    {
+        random,
+        sobol,
+        bluenoise,
+    };
 
-    virtual ~randomizer() = default;
+    sampler(const method sampler_method = method::random, const uint32_t seed = 0);
+
+    virtual ~sampler() = default;
+
+    void set(const uint32_t stream, const uint32_t sample, const uint32_t dimension = 0)
+    {
+        _stream    = stream;
+        _sample    = sample;
+        _dimension = dimension;
+    }
+
+    auto get_stream() const -> uint32_t
+    {
+        return _stream;
+    }
+
+    auto get_sample() const -> uint32_t
+    {
+        return _sample;
+    }
 
     float operator()()
     {
-        return _distributor(_generator);
+        return get(_dimension++);
     }
 
+    auto get(const uint32_t dimension) const -> float;
+
 protected:
-    mersenne_twister           _generator;
-    uniform_float_distribution _distributor;
+    auto get_sobol(const uint32_t dimension) const -> uint32_t;
+
+    auto get_bluenoise(const uint32_t dimension) const -> uint32_t;
+
+    static auto sobol(const uint32_t sample, const uint32_t dimension, const uint32_t seed) -> uint32_t;
+
+    static auto reverse(uint32_t value) -> uint32_t;
+
+    static auto scramble(uint32_t value, const uint32_t seed) -> uint32_t;
+
+    method   _method;
+    uint32_t _seed;
+    uint32_t _stream;
+    uint32_t _sample;
+    uint32_t _dimension;
 };
 
 }
@@ -212,6 +395,9 @@ public:
     void fetch();
 
     void close();
+
+protected:
+    int _format;
 };
 
 }
@@ -542,16 +728,16 @@ namespace gl {
 class col3f
 {
 public:
-    col3f()
+    constexpr col3f()
         : r(0.0f)
         , g(0.0f)
         , b(0.0f)
     {
     }
 
-    col3f ( const float color_r
-          , const float color_g
-          , const float color_b )
+    constexpr col3f ( const float color_r
+                    , const float color_g
+                    , const float color_b )
         : r(color_r)
         , g(color_g)
         , b(color_b)
@@ -676,6 +862,72 @@ public:
 
 }
 
+// ---------------------------------------------------------------------------
+// gl::box3f
+// ---------------------------------------------------------------------------
+
+namespace gl {
+
+class box3f
+{
+public:
+    box3f()
+        : min(+FLT_MAX, +FLT_MAX, +FLT_MAX)
+        , max(-FLT_MAX, -FLT_MAX, -FLT_MAX)
+    {
+    }
+
+    box3f ( const pos3f& box_min
+          , const pos3f& box_max )
+        : min(box_min)
+        , max(box_max)
+    {
+    }
+
+    box3f& operator+=(const pos3f& point)
+    {
+        min.x = std::min(min.x, point.x);
+        min.y = std::min(min.y, point.y);
+        min.z = std::min(min.z, point.z);
+        max.x = std::max(max.x, point.x);
+        max.y = std::max(max.y, point.y);
+        max.z = std::max(max.z, point.z);
+        return *this;
+    }
+
+    box3f& operator+=(const box3f& box)
+    {
+        min.x = std::min(min.x, box.min.x);
+        min.y = std::min(min.y, box.min.y);
+        min.z = std::min(min.z, box.min.z);
+        max.x = std::max(max.x, box.max.x);
+        max.y = std::max(max.y, box.max.y);
+        max.z = std::max(max.z, box.max.z);
+        return *this;
+    }
+
+    pos3f center() const
+    {
+        return pos3f ( ((min.x + max.x) * 0.5f)
+                     , ((min.y + max.y) * 0.5f)
+                     , ((min.z + max.z) * 0.5f) );
+    }
+
+    float area() const
+    {
+        const vec3f extent(pos3f::difference(max, min));
+
+        return 2.0f * ( (extent.x * extent.y)
+                      + (extent.y * extent.z)
+                      + (extent.z * extent.x) );
+    }
+
+    pos3f min;
+    pos3f max;
+};
+
+}
+
 // ---------------------------------------------------------------------------
 // rt::using
 // ---------------------------------------------------------------------------
@@ -686,6 +938,9 @@ using vec3f = gl::vec3f;
 using pos3f = gl::pos3f;
 using col3f = gl::col3f;
 using rec4i = gl::rec4i;
+using box3f = gl::box3f;
+
+class object;
 
 }
 
@@ -725,6 +980,56 @@ public:
 
 }
 
+// ---------------------------------------------------------------------------
+// rt::hit_record
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+/*
+ * the closest hit is tracked by distance and primitive only, the complete
+ * hit_result being resolved once for the winning primitive
+ */
+class hit_record
+{
+public:
+    enum class kind
+    {
+        none,
+        plane,
+        sphere,
+        object,
+    };
+
+    hit_record()
+        : distance(hit_result::DISTANCE_MAX)
+        , type(kind::none)
+        , owner(nullptr)
+        , primitive(-1)
+    {
+    }
+
+    void set(const float record_distance, const kind record_type, const object* record_owner, const int record_primitive)
+    {
+        distance  = record_distance;
+        type      = record_type;
+        owner     = record_owner;
+        primitive = record_primitive;
+    }
+
+    bool empty() const
+    {
+        return type == kind::none;
+    }
+
+    float         distance;
+    kind          type;
+    const object* owner;
+    int           primitive;
+};
+
+}
+
 // ---------------------------------------------------------------------------
 // rt::ray
 // ---------------------------------------------------------------------------
@@ -734,6 +1039,12 @@ namespace rt {
 class ray
 {
 public:
+    ray()
+        : origin()
+        , direction()
+    {
+    }
+
     ray ( const pos3f& ray_origin
         , const vec3f& ray_direction )
         : origin(ray_origin)
@@ -765,6 +1076,55 @@ public:
 
 }
 
+// ---------------------------------------------------------------------------
+// rt::ray_packet
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class ray_packet
+{
+public:
+    ray_packet();
+
+    void clear();
+
+    void add(const ray&);
+
+    auto size() const -> int
+    {
+        return _size;
+    }
+
+    auto mask() const -> uint32_t
+    {
+        return static_cast<uint32_t>((UINT64_C(1) << _size) - 1);
+    }
+
+    bool coherent() const
+    {
+        return _coherent;
+    }
+
+    static constexpr int LANES_MAX = 16;
+
+    alignas(64) float ox[LANES_MAX];
+    alignas(64) float oy[LANES_MAX];
+    alignas(64) float oz[LANES_MAX];
+    alignas(64) float ix[LANES_MAX];
+    alignas(64) float iy[LANES_MAX];
+    alignas(64) float iz[LANES_MAX];
+    ray               rays[LANES_MAX];
+    box3f             origins;
+    box3f             inverses;
+
+protected:
+    int  _size;
+    bool _coherent;
+};
+
+}
+
 // ---------------------------------------------------------------------------
 // rt::camera
 // ---------------------------------------------------------------------------
@@ -809,11 +1169,39 @@ class light
 public:
     light ( const pos3f& light_position
           , const col3f& light_color
-          , const float  light_power );
+          , const float  light_power
+          , const float  light_radius = 0.0f );
 
     pos3f position;
     col3f color;
     float power;
+    float radius;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::cone
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class cone
+{
+public:
+    cone ( const ray&  cone_axis
+         , const float cone_distance
+         , const float cone_radius );
+
+    bool enter(const box3f& bounds) const;
+
+    auto cover(const pos3f& center, const float radius) const -> float;
+
+    ray   axis;
+    float distance;
+    float radius;
+    float angle;
+    float tangent;
 };
 
 }
@@ -836,6 +1224,36 @@ public:
 
 }
 
+// ---------------------------------------------------------------------------
+// rt::material
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class material
+{
+public:
+    material ( const col3f& material_color0
+             , const col3f& material_color1
+             , const col3f& material_color2
+             , const float  material_reflect
+             , const float  material_refract
+             , const float  material_eta
+             , const float  material_specular );
+
+    bool operator==(const material& other) const;
+
+    col3f color0;
+    col3f color1;
+    col3f color2;
+    float reflect;
+    float refract;
+    float eta;
+    float specular;
+};
+
+}
+
 // ---------------------------------------------------------------------------
 // rt::object
 // ---------------------------------------------------------------------------
@@ -847,56 +1265,38 @@ class object
 public:
     object();
 
-    virtual ~object() = default;
+    virtual bool hit(const ray&, hit_record&) const = 0;
 
-    virtual bool hit(const ray&, hit_result&) const = 0;
+    virtual void resolve(const ray&, const hit_record&, const material&, hit_result&) const = 0;
 
-    void set_color0(const col3f& color0)
-    {
-        _color0 = color0;
-    }
+    virtual bool occluded(const ray&, const float distance) const = 0;
 
-    void set_color1(const col3f& color1)
-    {
-        _color1 = color1;
-    }
+    virtual auto visibility(const cone&) const -> float;
 
-    void set_color2(const col3f& color2)
-    {
-        _color2 = color2;
-    }
+    virtual auto occluder(const ray&, const float distance) const -> int;
 
-    void set_reflect(const float reflect)
-    {
-        _reflect = reflect;
-    }
+    virtual bool occludes(const ray&, const float distance, const int primitive) const;
 
-    void set_refract(const float refract)
-    {
-        _refract = refract;
-    }
+    virtual bool bounds(box3f&) const = 0;
 
-    void set_eta(const float eta)
+    void set_material(const int material)
     {
-        _eta = eta;
+        _material = material;
     }
 
-    void set_specular(const float specular)
+    auto get_material() const -> int
     {
-        _specular = specular;
+        return _material;
     }
 
-    using shared_ptr = std::shared_ptr<object>;
-    using vector     = std::vector<shared_ptr>;
+    using handle = const object*;
+    using vector = std::vector<handle>;
 
 protected:
-    col3f _color0;
-    col3f _color1;
-    col3f _color2;
-    float _reflect;
-    float _refract;
-    float _eta;
-    float _specular;
+    /* objects live in the scene arena and are never deleted polymorphically */
+    ~object() = default;
+
+    int _material;
 };
 
 }
@@ -915,9 +1315,46 @@ public:
           , const vec3f& plane_normal
           , const float  plane_scale );
 
-    virtual ~plane() = default;
+    ~plane() = default;
+
+    virtual bool hit(const ray&, hit_record&) const override;
+
+    virtual void resolve(const ray&, const hit_record&, const material&, hit_result&) const override;
+
+    virtual bool occluded(const ray&, const float distance) const override;
+
+    virtual bool bounds(box3f&) const override;
+
+    static auto checker ( const pos3f& position
+                        , const float  scale
+                        , const col3f& color1
+                        , const col3f& color2 ) -> const col3f&
+    {
+        const float x = ::roundf(position.x * scale);
+        const float y = ::roundf(position.y * scale);
+        const float z = ::roundf(position.z * scale);
+        const int   c = (static_cast<int>(x) & 1)
+                      ^ (static_cast<int>(y) & 1)
+                      ^ (static_cast<int>(z) & 1)
+                      ;
+
+        return (c != 0 ? color1 : color2);
+    }
+
+    auto get_position() const -> const pos3f&
+    {
+        return _position;
+    }
 
-    virtual bool hit(const ray&, hit_result&) const override;
+    auto get_normal() const -> const vec3f&
+    {
+        return _normal;
+    }
+
+    auto get_scale() const -> float
+    {
+        return _scale;
+    }
 
 protected:
     pos3f _position;
@@ -940,9 +1377,32 @@ public:
     sphere ( const pos3f& sphere_position
            , const float  sphere_radius );
 
-    virtual ~sphere() = default;
+    ~sphere() = default;
+
+    virtual bool hit(const ray&, hit_record&) const override;
+
+    virtual void resolve(const ray&, const hit_record&, const material&, hit_result&) const override;
+
+    virtual bool occluded(const ray&, const float distance) const override;
+
+    virtual auto visibility(const cone&) const -> float override;
+
+    virtual bool bounds(box3f&) const override;
+
+    auto get_position() const -> const pos3f&
+    {
+        return _position;
+    }
+
+    auto get_radius() const -> float
+    {
+        return _radius;
+    }
 
-    virtual bool hit(const ray&, hit_result&) const override;
+    void set_position(const pos3f& position)
+    {
+        _position = position;
+    }
 
 protected:
     pos3f _position;
@@ -952,12 +1412,113 @@ protected:
 }
 
 // ---------------------------------------------------------------------------
-// rt::cylinder
+// rt::sphere_grid
 // ---------------------------------------------------------------------------
 
 namespace rt {
 
-class cylinder final
+class sphere_grid final
+    : public object
+{
+public:
+    sphere_grid ( const pos3f& grid_origin
+                , const int    grid_cols
+                , const int    grid_rows
+                , const float  grid_radius );
+
+    ~sphere_grid() = default;
+
+    virtual bool hit(const ray&, hit_record&) const override;
+
+    virtual void resolve(const ray&, const hit_record&, const material&, hit_result&) const override;
+
+    virtual bool occluded(const ray&, const float distance) const override;
+
+    virtual auto visibility(const cone&) const -> float override;
+
+    virtual auto occluder(const ray&, const float distance) const -> int override;
+
+    virtual bool occludes(const ray&, const float distance, const int primitive) const override;
+
+    virtual bool bounds(box3f&) const override;
+
+    void set(const int col, const int row);
+
+    bool get(const int col, const int row) const;
+
+    auto count() const -> int
+    {
+        return _count;
+    }
+
+    auto get_center(const int primitive) const -> pos3f
+    {
+        return pos3f ( _origin.x + static_cast<float>(primitive % _cols)
+                     , _origin.y
+                     , _origin.z + static_cast<float>(primitive / _cols) );
+    }
+
+protected:
+    auto intersect(const ray&, const pos3f& center) const -> float;
+
+    template <typename Function>
+    bool walk(const ray&, const float& distance_limit, Function&& function) const;
+
+    auto fetch(const std::vector<uint64_t>& bits, const int col, const int row, const int width) const -> uint64_t;
+
+    auto next(const int col, const int row, const int step) const -> int;
+
+    pos3f                 _origin;
+    int                   _cols;
+    int                   _rows;
+    float                 _radius;
+    int                   _reach;
+    int                   _width;
+    int                   _height;
+    int                   _stride;
+    int                   _count;
+    box3f                 _bounds;
+    std::vector<uint64_t> _spheres;
+    std::vector<uint64_t> _cells;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere_lattice
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+template <typename World>
+class sphere_lattice final
+    : public object
+{
+public:
+    sphere_lattice();
+
+    ~sphere_lattice() = default;
+
+    virtual bool hit(const ray&, hit_record&) const override;
+
+    virtual void resolve(const ray&, const hit_record&, const material&, hit_result&) const override;
+
+    virtual bool occluded(const ray&, const float distance) const override;
+
+    virtual auto visibility(const cone&) const -> float override;
+
+    virtual bool bounds(box3f&) const override;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::cylinder
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class cylinder final
     : public object
 {
 public:
@@ -965,9 +1526,15 @@ public:
              , const pos3f& cylinder_point2
              , const float  cylinder_radius );
 
-    virtual ~cylinder() = default;
+    ~cylinder() = default;
+
+    virtual bool hit(const ray&, hit_record&) const override;
+
+    virtual void resolve(const ray&, const hit_record&, const material&, hit_result&) const override;
+
+    virtual bool occluded(const ray&, const float distance) const override;
 
-    virtual bool hit(const ray&, hit_result&) const override;
+    virtual bool bounds(box3f&) const override;
 
 protected:
     pos3f _point1;
@@ -977,87 +1544,669 @@ protected:
 
 }
 
+// ---------------------------------------------------------------------------
+// rt::bvh
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class bvh
+{
+public:
+    struct node
+    {
+        box3f bounds;
+        int   index;
+        int   count;
+    };
+
+    bvh();
+
+    virtual ~bvh() = default;
+
+    void build(const std::vector<box3f>& boxes, const int leaf_size = 1, const int threads = 1);
+
+    bool refit(const std::vector<box3f>& boxes);
+
+    void clear();
+
+    auto get_cost() const -> float;
+
+    auto get_nodes() const -> const std::vector<node>&
+    {
+        return _nodes;
+    }
+
+    auto get_indices() const -> const std::vector<int>&
+    {
+        return _indices;
+    }
+
+    template <typename Function>
+    void closest(const ray&, const vec3f& inverse, const float& distance, Function&& function) const;
+
+    template <typename Function>
+    bool any(const ray&, const vec3f& inverse, const float distance, Function&& function) const;
+
+    template <typename Function>
+    void closest(const ray_packet&, const float* distances, Function&& function) const;
+
+    template <typename Predicate, typename Function>
+    bool visit(Predicate&& predicate, Function&& function) const;
+
+    static bool enter ( const box3f& box
+                      , const pos3f& origin
+                      , const vec3f& inverse
+                      , const float  distance_max
+                      , float&       distance_hit );
+
+    static auto enter ( const box3f&      box
+                      , const ray_packet& packet
+                      , const float*      distances
+                      , const uint32_t    mask
+                      , float&            distance_hit ) -> uint32_t;
+
+    static constexpr int   LEAF_MAX     = 4;
+    static constexpr int   DEPTH_MAX    = 64;
+    static constexpr int   BINS_COUNT   = 32;
+    static constexpr int   SWEEP_MAX    = 256;
+    static constexpr int   PARALLEL_MIN = 16384;
+    static constexpr float COST_NODE    = 1.0f;
+    static constexpr float COST_LEAF    = 1.0f;
+    static constexpr float REFIT_MAX    = 1.5f;
+
+protected:
+    int build(const std::vector<box3f>& boxes, std::vector<node>& nodes, const int first, const int count, const int depth, const int threads);
+
+    std::vector<node> _nodes;
+    std::vector<int>  _indices;
+    int               _leaf_size;
+    float             _cost;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere_array
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class sphere_array
+{
+public:
+    using float_vector = std::vector<float, base::aligned_allocator<float>>;
+    using index_vector = std::vector<int32_t, base::aligned_allocator<int32_t>>;
+
+    sphere_array();
+
+    void clear();
+
+    void add(const pos3f& center, const float radius, const int material);
+
+    void permute(const std::vector<int>& indices);
+
+    auto size() const -> int
+    {
+        return static_cast<int>(radius.size());
+    }
+
+    float_vector x;
+    float_vector y;
+    float_vector z;
+    float_vector radius;
+    index_vector material;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::sphere_kernel
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class sphere_kernel
+{
+public:
+    static auto lanes() -> int;
+
+    static auto closest ( const sphere_array& spheres
+                        , const ray&          ray
+                        , const int           first
+                        , const int           count
+                        , float&              distance ) -> int;
+
+    static bool any ( const sphere_array& spheres
+                    , const ray&          ray
+                    , const int           first
+                    , const int           count
+                    , const float         distance );
+
+protected:
+    enum class level
+    {
+        scalar,
+        avx2,
+        avx512,
+    };
+
+    static auto get_level() -> level;
+
+    static auto closest_scalar(const sphere_array&, const ray&, const int first, const int last, float& distance) -> int;
+
+    static auto closest_avx2(const sphere_array&, const ray&, const int first, const int last, float& distance) -> int;
+
+    static auto closest_avx512(const sphere_array&, const ray&, const int first, const int last, float& distance) -> int;
+
+    static bool any_scalar(const sphere_array&, const ray&, const int first, const int last, const float distance);
+
+    static bool any_avx2(const sphere_array&, const ray&, const int first, const int last, const float distance);
+
+    static bool any_avx512(const sphere_array&, const ray&, const int first, const int last, const float distance);
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::plane_array
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class plane_array
+{
+public:
+    using float_vector = std::vector<float, base::aligned_allocator<float>>;
+    using index_vector = std::vector<int32_t, base::aligned_allocator<int32_t>>;
+
+    plane_array();
+
+    void clear();
+
+    void add(const pos3f& position, const vec3f& normal, const float scale, const int material);
+
+    auto size() const -> int
+    {
+        return static_cast<int>(scale.size());
+    }
+
+    float_vector px;
+    float_vector py;
+    float_vector pz;
+    float_vector nx;
+    float_vector ny;
+    float_vector nz;
+    float_vector scale;
+    index_vector material;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::glyph
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class glyph
+{
+public:
+    glyph(const float glyph_radius);
+
+    virtual ~glyph() = default;
+
+    void add(const pos3f& center);
+
+    void compile();
+
+    auto hit(const ray&, float& distance) const -> int;
+
+    bool occluded(const ray&, const float distance) const;
+
+    auto visibility(const cone&) const -> float;
+
+    auto occluder(const ray&, const float distance) const -> int;
+
+    bool occludes(const ray&, const float distance, const int primitive) const;
+
+    auto get_center(const int primitive) const -> pos3f
+    {
+        return pos3f(_spheres.x[primitive], _spheres.y[primitive], _spheres.z[primitive]);
+    }
+
+    auto get_bounds() const -> const box3f&
+    {
+        return _bounds;
+    }
+
+    auto size() const -> int
+    {
+        return _spheres.size();
+    }
+
+protected:
+    float        _radius;
+    sphere_array _spheres;
+    bvh          _bvh;
+    box3f        _bounds;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::instance
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class instance final
+    : public object
+{
+public:
+    instance ( const glyph& instance_glyph
+             , const vec3f& instance_offset );
+
+    ~instance() = default;
+
+    virtual bool hit(const ray&, hit_record&) const override;
+
+    virtual void resolve(const ray&, const hit_record&, const material&, hit_result&) const override;
+
+    virtual bool occluded(const ray&, const float distance) const override;
+
+    virtual auto visibility(const cone&) const -> float override;
+
+    virtual auto occluder(const ray&, const float distance) const -> int override;
+
+    virtual bool occludes(const ray&, const float distance, const int primitive) const override;
+
+    virtual bool bounds(box3f&) const override;
+
+    auto get_offset() const -> const vec3f&
+    {
+        return _offset;
+    }
+
+    void set_offset(const vec3f& offset)
+    {
+        _offset = offset;
+    }
+
+protected:
+    auto to_local(const ray&) const -> ray;
+
+    const glyph& _glyph;
+    vec3f        _offset;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::light_tree
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class light_tree
+{
+public:
+    struct node
+    {
+        box3f bounds;
+        float energy;
+        int   index;
+        int   count;
+    };
+
+    light_tree();
+
+    virtual ~light_tree() = default;
+
+    void build(const std::vector<light>& lights);
+
+    void clear();
+
+    auto sample(const pos3f& position, float random, float& probability) const -> int;
+
+    auto get_nodes() const -> const std::vector<node>&
+    {
+        return _nodes;
+    }
+
+    static constexpr int   LINEAR_MAX   = 16;
+    static constexpr float DISTANCE_MIN = 0.01f;
+
+protected:
+    auto build(const int first, const int count) -> int;
+
+    static auto importance(const box3f& bounds, const float energy, const pos3f& position) -> float;
+
+    std::vector<node>  _nodes;
+    std::vector<int>   _indices;
+    std::vector<pos3f> _positions;
+    std::vector<float> _energies;
+};
+
+}
+
 // ---------------------------------------------------------------------------
 // rt::scene
 // ---------------------------------------------------------------------------
 
 namespace rt {
 
-class scene
+class scene
+{
+public:
+    scene ( const camera& scene_camera
+          , const light&  scene_light
+          , const sky&    scene_sky );
+
+    virtual ~scene() = default;
+
+    auto get_camera() const -> const camera&
+    {
+        return _camera;
+    }
+
+    auto get_light() const -> const light&
+    {
+        return _lights.front();
+    }
+
+    auto get_lights() const -> const std::vector<light>&
+    {
+        return _lights;
+    }
+
+    auto get_light_tree() const -> const light_tree&
+    {
+        return _light_tree;
+    }
+
+    void add_light(const light& light)
+    {
+        _lights.push_back(light);
+    }
+
+    void set_light(const int index, const pos3f& position, const float power);
+
+    auto get_sky() const -> const sky&
+    {
+        return _sky;
+    }
+
+    auto get_objects() const -> const auto&
+    {
+        return _objects;
+    }
+
+    template <typename T, typename... Args>
+    T& create(Args&&... args)
+    {
+        return _arena.create<T>(std::forward<Args>(args)...);
+    }
+
+    void add(const object& object)
+    {
+        _objects.push_back(&object);
+    }
+
+    auto add_material(const material&) -> int;
+
+    void set_material(const int index, const material&);
+
+    auto get_material(const int index) const -> const material&
+    {
+        return _materials[index];
+    }
+
+    auto get_materials() const -> const std::vector<material>&
+    {
+        return _materials;
+    }
+
+    void compile(const int threads = 1);
+
+    void update(const int threads = 1);
+
+    auto get_spheres_bvh() const -> const bvh&
+    {
+        return _spheres_bvh;
+    }
+
+    auto get_objects_bvh() const -> const bvh&
+    {
+        return _bounded_bvh;
+    }
+
+    bool hit(const ray&, hit_record&) const;
+
+    auto hit(const ray_packet&, hit_record* records) const -> uint32_t;
+
+    void resolve(const ray&, const hit_record&, hit_result&) const;
+
+    bool occluded(const ray&, const float distance, hit_record& occluder) const;
+
+    bool occludes(const ray&, const float distance, const hit_record& occluder) const;
+
+    auto visibility(const cone&) const -> float;
+
+protected:
+    bool hit_planes(const ray&, hit_record&) const;
+
+    bool plane_occludes(const int index, const ray&, const float distance) const;
+
+    camera                     _camera;
+    std::vector<light>         _lights;
+    light_tree                 _light_tree;
+    sky                        _sky;
+    base::arena                _arena;
+    object::vector             _objects;
+    std::vector<material>      _materials;
+    plane_array                _planes;
+    sphere_array               _spheres;
+    bvh                        _spheres_bvh;
+    std::vector<const sphere*> _spheres_objects;
+    std::vector<const object*> _unbounded;
+    std::vector<const object*> _bounded;
+    bvh                        _bounded_bvh;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::ray_queue
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class ray_queue
+{
+public:
+    using float_vector = std::vector<float, base::aligned_allocator<float>>;
+    using index_vector = std::vector<int32_t, base::aligned_allocator<int32_t>>;
+
+    ray_queue();
+
+    void clear();
+
+    void add(const ray& ray, const col3f& weight, const float distance, const int pixel, const uint32_t stream, const uint32_t dimension);
+
+    void sort();
+
+    void swap(ray_queue&);
+
+    auto size() const -> int
+    {
+        return static_cast<int>(pixel.size());
+    }
+
+    auto get_ray(const int index) const -> ray;
+
+    auto get_weight(const int index) const -> col3f
+    {
+        return col3f(wr[index], wg[index], wb[index]);
+    }
+
+    float_vector ox;
+    float_vector oy;
+    float_vector oz;
+    float_vector dx;
+    float_vector dy;
+    float_vector dz;
+    float_vector wr;
+    float_vector wg;
+    float_vector wb;
+    float_vector distance;
+    index_vector pixel;
+    index_vector stream;
+    index_vector dimension;
+
+protected:
+    index_vector _keys;
+    index_vector _order;
+    float_vector _floats;
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// rt::raytracer
+// ---------------------------------------------------------------------------
+
+namespace rt {
+
+class raytracer
 {
 public:
-    scene ( const camera& scene_camera
-          , const light&  scene_light
-          , const sky&    scene_sky );
+    raytracer(const scene&, const int recursions, const base::sampler& sampler = base::sampler());
 
-    virtual ~scene() = default;
+    virtual ~raytracer() = default;
 
-    auto get_camera() const -> const camera&
+    struct statistics
     {
-        return _camera;
+        uint64_t shadow_rays;
+        uint64_t occluded;
+        uint64_t cache_hits;
+    };
+
+    col3f trace(const ray&, const int depth);
+
+    void trace(const ray_packet&, const int depth, col3f* colors);
+
+    bool hit(const ray&, hit_record& record);
+
+    bool occluded(const ray&, const float distance);
+
+    auto visibility(const ray&, const float distance, const float radius) -> float;
+
+    void set_sample(const uint32_t stream, const uint32_t sample, const uint32_t dimension = 0)
+    {
+        _sampler.set(stream, sample, dimension);
     }
 
-    auto get_light() const -> const light&
+    double random1()
     {
-        return _light;
+        return (_sampler() - 0.5f);
     }
 
-    auto get_sky() const -> const sky&
+    double random2()
     {
-        return _sky;
+        return (_sampler() - 0.5f) * 1.5f;
     }
 
-    auto get_objects() const -> const auto&
+    void set_termination(const float cutoff, const int roulette, const bool stochastic)
     {
-        return _objects;
+        _cutoff     = cutoff;
+        _roulette   = roulette;
+        _stochastic = stochastic;
+    }
+
+    void set_light_samples(const int light_samples)
+    {
+        _light_samples = light_samples;
     }
 
-    template <typename T>
-    void add(T& object_ptr)
+    void set_analytic_shadows(const bool analytic_shadows)
     {
-        _objects.push_back(std::move(object_ptr));
+        _analytic_shadows = analytic_shadows;
     }
 
+    auto get_statistics() const -> const statistics&
+    {
+        return _statistics;
+    }
+
+    static constexpr uint32_t CAMERA_DIMENSIONS = 4;
+    static constexpr uint32_t BOUNCE_DIMENSIONS = 128;
+    static constexpr uint32_t HEAP_BLOCKS = (UINT32_C(1) << 24);
+    static constexpr int      LIGHTS_MAX = 16;
+
 protected:
-    camera         _camera;
-    light          _light;
-    sky            _sky;
-    object::vector _objects;
+    struct pending
+    {
+        ray      path;
+        float    weight;
+        float    factor;
+        int      depth;
+        int      bounce;
+        uint32_t dimension;
+    };
+
+    col3f integrate(const ray&, const int depth, const hit_record* record);
+
+    auto shade(const pending& entry, const hit_result& result, pending* children, col3f& color) -> int;
+
+    bool survive(const float weight, float& factor, const int bounce, const uint32_t dimension);
+
+    void branch(float& reflect_factor, float& refract_factor);
+
+    static auto child_dimension(const uint32_t parent, const uint32_t child) -> uint32_t;
+
+    auto select(const pos3f& position, int* lights, float* scales) -> int;
+
+    const scene&  _scene;
+    base::sampler _sampler;
+    float         _cutoff;
+    int           _roulette;
+    bool          _stochastic;
+    int           _light_samples;
+    bool          _analytic_shadows;
+    hit_record    _occluder;
+    statistics    _statistics;
+    std::vector<pending> _stack;
 };
 
 }
 
 // ---------------------------------------------------------------------------
-// rt::raytracer
+// rt::wavefront
 // ---------------------------------------------------------------------------
 
 namespace rt {
 
-class raytracer
+class wavefront
+    : public raytracer
 {
 public:
-    raytracer(const scene&);
+    wavefront(const scene&, const base::sampler& sampler = base::sampler());
 
-    virtual ~raytracer() = default;
+    virtual ~wavefront() = default;
 
-    col3f trace(const ray&, const int depth);
+    void trace(ray_queue& rays, const int depth, const int packets, col3f* pixels);
 
-    bool hit(const ray&, hit_result& result);
+protected:
+    void extend(const ray_queue& rays, const int packets);
 
-    double random1()
-    {
-        return _random1();
-    }
+    void shade(const ray_queue& rays, col3f* pixels, const int bounce);
 
-    double random2()
-    {
-        return _random2();
-    }
+    void shadow(const ray_queue& shadows, col3f* pixels);
 
-protected:
-    const scene&     _scene;
-    base::randomizer _random1;
-    base::randomizer _random2;
+    std::vector<hit_record> _records;
+    ray_queue               _shadows;
+    ray_queue               _secondary;
 };
 
 }
@@ -1075,17 +2224,421 @@ public:
 
     virtual ~renderer() = default;
 
+    enum class mode
+    {
+        recursive,
+        wavefront,
+    };
+
     void render ( ppm::writer& output
                 , const int    samples
                 , const int    recursions
                 , const int    threads );
 
+    void set_mode(const mode render_mode)
+    {
+        _mode = render_mode;
+    }
+
+    void set_packets(const int packets)
+    {
+        _packets = packets;
+    }
+
+    void set_seed(const uint32_t seed)
+    {
+        _seed = seed;
+    }
+
+    void set_sampler(const base::sampler::method sampler)
+    {
+        _sampler = sampler;
+    }
+
+    void set_termination(const float cutoff, const int roulette, const bool stochastic)
+    {
+        _cutoff     = cutoff;
+        _roulette   = roulette;
+        _stochastic = stochastic;
+    }
+
+    void set_light_samples(const int light_samples)
+    {
+        _light_samples = light_samples;
+    }
+
+    void set_analytic_shadows(const bool analytic_shadows)
+    {
+        _analytic_shadows = analytic_shadows;
+    }
+
+    void set_adaptive(const float threshold, const int max_samples)
+    {
+        _threshold   = threshold;
+        _max_samples = max_samples;
+    }
+
+    void set_progressive(const bool progressive, const double budget = 0.0)
+    {
+        _progressive = progressive;
+        _budget      = budget;
+    }
+
+    void cancel()
+    {
+        _cancelled.store(true);
+    }
+
+    static constexpr int PASS_SAMPLES = 8;
+
+    auto get_traced() const -> uint64_t
+    {
+        return _traced;
+    }
+
+    auto get_statistics() const -> const raytracer::statistics&
+    {
+        return _statistics;
+    }
+
 protected:
     const scene&             _scene;
     std::mutex               _mutex;
     std::queue<rec4i>        _tiles;
     std::vector<std::thread> _threads;
+    mode                     _mode;
+    int                      _packets;
+    uint32_t                 _seed;
+    base::sampler::method    _sampler;
+    float                    _cutoff;
+    int                      _roulette;
+    bool                     _stochastic;
+    int                      _light_samples;
+    bool                     _analytic_shadows;
+    float                    _threshold;
+    int                      _max_samples;
+    bool                     _progressive;
+    double                   _budget;
+    std::atomic<bool>        _cancelled;
+    uint64_t                 _traced;
+    raytracer::statistics    _statistics;
+
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// card::world
+// ---------------------------------------------------------------------------
+
+namespace card {
+
+class world
+{
+public:
+    static constexpr auto cols() -> int
+    {
+        return 32;
+    }
+
+    static constexpr auto rows() -> int
+    {
+        return 16;
+    }
+
+    static constexpr auto col_offset() -> float
+    {
+        return -16.0f;
+    }
+
+    static constexpr auto row_offset() -> float
+    {
+        return 0.0f;
+    }
+
+    static constexpr auto row(const int index) -> uint32_t
+    {
+        return 0;
+    }
+
+    static constexpr auto sphere_radius() -> float
+    {
+        return 1.0f;
+    }
+
+    static constexpr auto sphere_color() -> rt::col3f
+    {
+        return rt::col3f(0.20f, 0.25f, 0.15f);
+    }
+
+    static constexpr auto sphere_reflect() -> float
+    {
+        return 0.5f;
+    }
+
+    static constexpr auto sphere_refract() -> float
+    {
+        return 0.0f;
+    }
+
+    static constexpr auto sphere_eta() -> float
+    {
+        return 1.0f;
+    }
+
+    static constexpr auto sphere_specular() -> float
+    {
+        return 50.0f;
+    }
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// card::world_aek
+// ---------------------------------------------------------------------------
+
+namespace card {
+
+class world_aek final
+    : public world
+{
+public:
+    static constexpr auto row(const int index) -> uint32_t
+    {
+        constexpr uint32_t rows[16] = {
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000010000000000,
+            0b00000000000000000000010000000000,
+            0b00000000111000011100010000000000,
+            0b00000000000100100010010001000000,
+            0b00000000000100100010010010000000,
+            0b00000000111100111110010100000000,
+            0b00000001000100100000011000000000,
+            0b00000001000100100000010100000000,
+            0b00000000111100011100010010000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+        };
+        return rows[index];
+    }
+
+    static constexpr auto sphere_radius() -> float
+    {
+        return 1.0f;
+    }
+
+    static constexpr auto sphere_color() -> rt::col3f
+    {
+        return rt::col3f(+0.0f, +0.0f, +0.0f);
+    }
+
+    static constexpr auto sphere_reflect() -> float
+    {
+        return 0.7f;
+    }
+
+    static constexpr auto sphere_refract() -> float
+    {
+        return 0.0f;
+    }
+
+    static constexpr auto sphere_specular() -> float
+    {
+        return 99.0f;
+    }
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// card::world_ponceto
+// ---------------------------------------------------------------------------
+
+namespace card {
+
+class world_ponceto final
+    : public world
+{
+public:
+    static constexpr auto row(const int index) -> uint32_t
+    {
+        constexpr uint32_t rows[16] = {
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b11100011001001001110111101110110,
+            0b10010100101001010000100000101001,
+            0b10010100101101010000100000101001,
+            0b11100100101101010000111000101001,
+            0b10000100101011010000100000101001,
+            0b10000100101011010000100000101001,
+            0b10000011001001001110111100100110,
+        };
+        return rows[index];
+    }
+
+    static constexpr auto sphere_radius() -> float
+    {
+        return 0.75f;
+    }
+
+    static constexpr auto sphere_color() -> rt::col3f
+    {
+        return rt::col3f(+1.0f, +0.8f, +0.0f);
+    }
+
+    static constexpr auto sphere_reflect() -> float
+    {
+        return 0.7f;
+    }
+
+    static constexpr auto sphere_refract() -> float
+    {
+        return 0.0f;
+    }
+
+    static constexpr auto sphere_specular() -> float
+    {
+        return 99.0f;
+    }
+};
 
+}
+
+// ---------------------------------------------------------------------------
+// card::world_smiley
+// ---------------------------------------------------------------------------
+
+namespace card {
+
+class world_smiley final
+    : public world
+{
+public:
+    static constexpr auto row(const int index) -> uint32_t
+    {
+        constexpr uint32_t rows[16] = {
+            0b00000000000001111110000000000000,
+            0b00000000000110000001100000000000,
+            0b00000000001000000000010000000000,
+            0b00000000010000000000001000000000,
+            0b00000000010001100110001000000000,
+            0b00000000100001100110000100000000,
+            0b00000000100000000000000100000000,
+            0b00000000100000000000000100000000,
+            0b00000000100000000000000100000000,
+            0b00000000100100000000100100000000,
+            0b00000000100010000001000100000000,
+            0b00000000010001111110001000000000,
+            0b00000000010000000000001000000000,
+            0b00000000001000000000010000000000,
+            0b00000000000110000001100000000000,
+            0b00000000000001111110000000000000,
+        };
+        return rows[index];
+    }
+
+    static constexpr auto sphere_radius() -> float
+    {
+        return 1.0f;
+    }
+
+    static constexpr auto sphere_color() -> rt::col3f
+    {
+        return rt::col3f(+0.1f, +0.2f, +0.3f);
+    }
+
+    static constexpr auto sphere_reflect() -> float
+    {
+        return 0.7f;
+    }
+
+    static constexpr auto sphere_refract() -> float
+    {
+        return 0.0f;
+    }
+
+    static constexpr auto sphere_specular() -> float
+    {
+        return 99.0f;
+    }
+};
+
+}
+
+// ---------------------------------------------------------------------------
+// card::world_simple
+// ---------------------------------------------------------------------------
+
+namespace card {
+
+class world_simple final
+    : public world
+{
+public:
+    static constexpr auto row(const int index) -> uint32_t
+    {
+        constexpr uint32_t rows[16] = {
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000000000000000000000,
+            0b00000000000000100100000000000000,
+        };
+        return rows[index];
+    }
+
+    static constexpr auto sphere_radius() -> float
+    {
+        return 1.0f;
+    }
+
+    static constexpr auto sphere_color() -> rt::col3f
+    {
+        return rt::col3f(0.15f, 0.35f, 0.25f);
+    }
+
+    static constexpr auto sphere_reflect() -> float
+    {
+        return 0.20f;
+    }
+
+    static constexpr auto sphere_refract() -> float
+    {
+        return 0.70f;
+    }
+
+    static constexpr auto sphere_eta() -> float
+    {
+        return 0.70f;
+    }
+
+    static constexpr auto sphere_specular() -> float
+    {
+        return 90.0f;
+    }
 };
 
 }
@@ -1103,11 +2656,14 @@ public:
 
     virtual ~scene_factory() = default;
 
-    static std::shared_ptr<rt::scene> create(const std::string& scene_name);
+    static std::shared_ptr<rt::scene> create(const std::string& scene_name, const int threads = 1);
 
 protected:
     void initialize();
 
+    template <typename World>
+    void initialize_world();
+
     void initialize_aek();
 
     void initialize_ponceto();
@@ -1118,7 +2674,15 @@ protected:
 
     void initialize_spheres();
 
-    std::shared_ptr<rt::scene> build();
+    void initialize_bitmap(const std::string& filename);
+
+    void initialize_random(const std::string& parameters);
+
+    std::shared_ptr<rt::scene> build(const int threads);
+
+    bool build_lattice(rt::scene&, const int material);
+
+    void build_instances(rt::scene&, const int material);
 
     void build_aek(rt::scene&);
 
@@ -1130,34 +2694,50 @@ protected:
 
     void build_spheres(rt::scene&);
 
+    void build_random(rt::scene&);
+
+    void build_accents(rt::scene&);
+
 protected:
-    std::string _name;
-    uint32_t    _world[16];
-    rt::pos3f   _camera_position;
-    rt::pos3f   _camera_target;
-    rt::pos3f   _camera_top;
-    float       _camera_fov;
-    float       _camera_dof;
-    float       _camera_focus;
-    rt::pos3f   _light_position;
-    rt::col3f   _light_color;
-    float       _light_power;
-    rt::col3f   _sky_color;
-    rt::col3f   _sky_ambient;
-    rt::pos3f   _floor_position;
-    rt::vec3f   _floor_normal;
-    rt::col3f   _floor_color1;
-    rt::col3f   _floor_color2;
-    float       _floor_scale;
-    float       _floor_reflect;
-    float       _floor_refract;
-    float       _floor_specular;
-    float       _sphere_radius;
-    rt::col3f   _sphere_color;
-    float       _sphere_reflect;
-    float       _sphere_refract;
-    float       _sphere_eta;
-    float       _sphere_specular;
+    std::string          _name;
+    bool                 _lattice;
+    bool                 _instanced;
+    int                  _accents;
+    int                  _world_cols;
+    int                  _world_rows;
+    std::vector<uint8_t> _world;
+    int                  _random_count;
+    uint32_t             _random_seed;
+    float                _random_density;
+    int                  _random_clusters;
+    float                _random_reflect;
+    float                _random_refract;
+    rt::pos3f            _camera_position;
+    rt::pos3f            _camera_target;
+    rt::pos3f            _camera_top;
+    float                _camera_fov;
+    float                _camera_dof;
+    float                _camera_focus;
+    rt::pos3f            _light_position;
+    rt::col3f            _light_color;
+    float                _light_power;
+    float                _light_radius;
+    rt::col3f            _sky_color;
+    rt::col3f            _sky_ambient;
+    rt::pos3f            _floor_position;
+    rt::vec3f            _floor_normal;
+    rt::col3f            _floor_color1;
+    rt::col3f            _floor_color2;
+    float                _floor_scale;
+    float                _floor_reflect;
+    float                _floor_refract;
+    float                _floor_specular;
+    float                _sphere_radius;
+    rt::col3f            _sphere_color;
+    float                _sphere_reflect;
+    float                _sphere_refract;
+    float                _sphere_eta;
+    float                _sphere_specular;
 };
 
 }
@@ -1184,14 +2764,27 @@ public:
     void usage();
 
 protected:
-    std::string _program;
-    std::string _output;
-    std::string _scene;
-    int         _card_w;
-    int         _card_h;
-    int         _samples;
-    int         _recursions;
-    int         _threads;
+    std::string           _program;
+    std::string           _output;
+    std::string           _scene;
+    int                   _card_w;
+    int                   _card_h;
+    int                   _samples;
+    int                   _recursions;
+    int                   _threads;
+    int                   _packets;
+    uint32_t              _seed;
+    base::sampler::method _sampler;
+    float                 _cutoff;
+    int                   _roulette;
+    bool                  _stochastic;
+    int                   _light_samples;
+    bool                  _analytic_shadows;
+    float                 _threshold;
+    int                   _max_samples;
+    bool                  _progressive;
+    double                _budget;
+    rt::renderer::mode    _mode;
 };
 
 }